@@ -27,23 +27,46 @@
 #ifndef DISTRHO_PLUGIN_INFO_H
 #define DISTRHO_PLUGIN_INFO_H
 
+// the number of channels analyzed, set by the build; the builds for other
+// counts than 2 are distinct plugins
+#ifndef SPECTACLE_NUM_CHANNELS
+#   define SPECTACLE_NUM_CHANNELS 2
+#endif
+
+#define SPECTACLE_STRINGIFY_(x) #x
+#define SPECTACLE_STRINGIFY(x) SPECTACLE_STRINGIFY_(x)
+
 #define DISTRHO_PLUGIN_BRAND "JPC"
-#define DISTRHO_PLUGIN_NAME "Spectacle"
-#define DISTRHO_PLUGIN_URI "https://jpcima.sdf1.org/plugins/spectacle"
+#if SPECTACLE_NUM_CHANNELS == 2
+#   define DISTRHO_PLUGIN_NAME "Spectacle"
+#   define DISTRHO_PLUGIN_URI "https://jpcima.sdf1.org/plugins/spectacle"
+#   define SPECTACLE_PLUGIN_LABEL "Spectacle"
+#else
+#   define DISTRHO_PLUGIN_NAME "Spectacle " SPECTACLE_STRINGIFY(SPECTACLE_NUM_CHANNELS) "ch"
+#   define DISTRHO_PLUGIN_URI "https://jpcima.sdf1.org/plugins/spectacle-" SPECTACLE_STRINGIFY(SPECTACLE_NUM_CHANNELS) "ch"
+#   define SPECTACLE_PLUGIN_LABEL "Spectacle" SPECTACLE_STRINGIFY(SPECTACLE_NUM_CHANNELS) "ch"
+#endif
 
 #define DISTRHO_PLUGIN_HAS_UI 1
 #define DISTRHO_UI_USER_RESIZABLE 1
 #define DISTRHO_UI_USE_NANOVG 1
 
 #define DISTRHO_PLUGIN_IS_RT_SAFE 1
-#define DISTRHO_PLUGIN_NUM_INPUTS 2
+#define DISTRHO_PLUGIN_NUM_INPUTS SPECTACLE_NUM_CHANNELS
 #define DISTRHO_PLUGIN_NUM_OUTPUTS DISTRHO_PLUGIN_NUM_INPUTS
 #define DISTRHO_PLUGIN_WANT_TIMEPOS 0
 #define DISTRHO_PLUGIN_WANT_PROGRAMS 1
 #define DISTRHO_PLUGIN_WANT_MIDI_INPUT 0
 #define DISTRHO_PLUGIN_WANT_MIDI_OUTPUT 0
 
+// the editor reads the frames from the plugin when they are in the same
+// process, and receives them as states otherwise
 #define DISTRHO_PLUGIN_WANT_DIRECT_ACCESS 1
+#define DISTRHO_PLUGIN_WANT_STATE 1
+
+// room in the event ports for a fragment of an encoded frame, of at most
+// kFrameFragmentSize characters, and the message around it
+#define DISTRHO_PLUGIN_MINIMUM_BUFFER_SIZE 65536
 
 #define DISTRHO_PLUGIN_LV2_CATEGORY "lv2:AnalyserPlugin"
 
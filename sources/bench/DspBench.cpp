@@ -0,0 +1,277 @@
+#include "dsp/STFT.h"
+#include "dsp/MultirateSTFT.h"
+#include "dsp/Smoother.h"
+#include "dsp/Oversampling.h"
+#include "dsp/FFTPlanner.h"
+#include "dsp/AnalyzerDefs.h"
+#include "blink/DenormalDisabler.h"
+#include <getopt.h>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+///
+// Prints one CSV row per measurement:
+//   stage,size,step,iterations,seconds,samples_per_second,ns_per_bin
+// `size` is the window size, or the decimation factor of the downsamplers.
+// A figure which does not apply to a stage is left empty.
+
+static double gMinTime = 0.1;
+static const char *gFilter = nullptr;
+
+static bool isSelected(const char *stage)
+{
+    return !gFilter || std::strstr(stage, gFilter);
+}
+
+template <class F>
+static void measure(const char *stage, uint32_t size, uint32_t step, double samples, double bins, F &&fn)
+{
+    typedef std::chrono::steady_clock clock;
+
+    // warm up, then double the iterations until it runs long enough
+    fn();
+
+    uint64_t iterations = 1;
+    double seconds;
+    for (;;) {
+        clock::time_point t1 = clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            fn();
+        clock::time_point t2 = clock::now();
+        seconds = std::chrono::duration<double>(t2 - t1).count();
+        if (seconds >= gMinTime)
+            break;
+        iterations *= 2;
+    }
+
+    std::string samplesPerSecond;
+    if (samples > 0)
+        samplesPerSecond = std::to_string(samples * iterations / seconds);
+    std::string nsPerBin;
+    if (bins > 0)
+        nsPerBin = std::to_string(seconds * 1e9 / (bins * iterations));
+
+    std::string stepString;
+    if (step > 0)
+        stepString = std::to_string(step);
+
+    std::printf("%s,%u,%s,%llu,%.9f,%s,%s\n",
+                stage, size, stepString.c_str(), (unsigned long long)iterations, seconds,
+                samplesPerSecond.c_str(), nsPerBin.c_str());
+    std::fflush(stdout);
+}
+
+static std::vector<float> makeNoise(uint32_t count)
+{
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> noise(count);
+    for (float &x : noise)
+        x = dist(prng);
+    return noise;
+}
+
+static Configuration makeConfig(uint32_t windowSize, uint32_t stepSize)
+{
+    Configuration config;
+    config.windowSize = windowSize;
+    config.stepSize = stepSize;
+    config.sampleRate = 44100.0;
+    return config;
+}
+
+///
+static const uint32_t kBlockSize = 1024;
+
+static void benchPlanner()
+{
+    const char *stage = "FFTPlanner::forwardFFT";
+    if (!isSelected(stage))
+        return;
+
+    // plans are cached, only the first request of each size is measured
+    typedef std::chrono::steady_clock clock;
+    for (uint32_t sizeLog2 = kStftMinSizeLog2; sizeLog2 <= kStftMaxSizeLog2; ++sizeLog2) {
+        const uint32_t size = 1u << sizeLog2;
+        clock::time_point t1 = clock::now();
+        FFTPlanner::getInstance().forwardFFT(size);
+        clock::time_point t2 = clock::now();
+        const double seconds = std::chrono::duration<double>(t2 - t1).count();
+        std::printf("%s,%u,,1,%.9f,,\n", stage, size, seconds);
+    }
+    std::fflush(stdout);
+}
+
+static void benchStftBlock()
+{
+    const char *stage = "STFT::processNewBlock";
+    if (!isSelected(stage))
+        return;
+
+    for (uint32_t sizeLog2 = kStftMinSizeLog2; sizeLog2 <= kStftMaxSizeLog2; ++sizeLog2) {
+        const uint32_t size = 1u << sizeLog2;
+        STFT stft;
+        stft.configure(makeConfig(size, kStftDefaultStep));
+        const std::vector<float> noise = makeNoise(size);
+        std::vector<float> block(size);
+        measure(stage, size, 0, size, stft.getNumBins(), [&]() {
+            // the transform is out-of-place, but refresh the input anyway
+            std::copy(noise.begin(), noise.end(), block.begin());
+            stft.processNewBlock(block.data());
+        });
+    }
+}
+
+static void benchAnalyzer(const char *stage, BasicAnalyzer &analyzer)
+{
+    if (!isSelected(stage))
+        return;
+
+    const std::vector<float> noise = makeNoise(kBlockSize);
+
+    for (uint32_t sizeLog2 = kStftMinSizeLog2; sizeLog2 <= kStftMaxSizeLog2; ++sizeLog2) {
+        for (uint32_t stepLog2 = kStftMinStepLog2; stepLog2 <= kStftMaxStepLog2; ++stepLog2) {
+            const uint32_t size = 1u << sizeLog2;
+            const uint32_t step = 1u << stepLog2;
+            analyzer.configure(makeConfig(size, step));
+            analyzer.clear();
+            // per block, the bins produced on average at this step
+            const double bins = (double)analyzer.getNumBins() * kBlockSize / step;
+            measure(stage, size, step, kBlockSize, bins, [&]() {
+                analyzer.process(noise.data(), kBlockSize);
+            });
+        }
+    }
+}
+
+template <uint32_t Rates>
+static void benchMultirate()
+{
+    const std::string stage = "MultirateSTFT<" + std::to_string(Rates) + ">::process";
+    MultirateSTFT<Rates> analyzer;
+    benchAnalyzer(stage.c_str(), analyzer);
+}
+
+static void benchSmoother()
+{
+    const char *stage = "Smoother::process";
+    if (!isSelected(stage))
+        return;
+
+    for (uint32_t sizeLog2 = kStftMinSizeLog2; sizeLog2 <= kStftMaxSizeLog2; ++sizeLog2) {
+        const uint32_t size = 1u << sizeLog2;
+        const uint32_t numBins = size / 2 + 1;
+        Smoother smoother;
+        smoother.configure(numBins, kStftDefaultStep, kStftDefaultAttackTime, kStftDefaultReleaseTime, 44100.0);
+        const std::vector<float> noise = makeNoise(numBins);
+        std::vector<float> frame(numBins);
+        measure(stage, size, kStftDefaultStep, 0, numBins, [&]() {
+            std::copy(noise.begin(), noise.end(), frame.begin());
+            smoother.process(frame.data());
+        });
+    }
+}
+
+template <uint32_t Log2Factor>
+static void benchDownsampler()
+{
+    const std::string stage = "Downsampler<" + std::to_string(Log2Factor) + ">::downsample";
+    if (!isSelected(stage.c_str()))
+        return;
+
+    constexpr uint32_t factor = 1u << Log2Factor;
+    const std::vector<float> noise = makeNoise(kBlockSize);
+
+    // the outputs of successive rates, like the multirate analyzer
+    std::vector<float> temp(kBlockSize);
+    float *outputs[Log2Factor];
+    outputs[0] = temp.data();
+    for (uint32_t r = 1, l = kBlockSize / 2; r < Log2Factor; ++r, l /= 2)
+        outputs[r] = outputs[r - 1] + l;
+
+    Downsampler<Log2Factor> downsampler;
+    measure(stage.c_str(), factor, 0, kBlockSize, 0, [&]() {
+        downsampler.downsample(kBlockSize / factor, noise.data(), outputs);
+    });
+}
+
+///
+static void usage()
+{
+    std::fprintf(stderr,
+        "Usage: spectacle-analyzer-bench-dsp [options]\n"
+        "\n"
+        "Measures the throughput of the analysis stages, and prints CSV.\n"
+        "\n"
+        "Options:\n"
+        "  -t, --min-time=S   minimum duration of a measurement (default: %g)\n"
+        "  -f, --filter=TEXT  only run the stages whose name contains TEXT\n"
+        "  -h, --help         show this help\n",
+        gMinTime);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option longOptions[] = {
+        {"min-time", required_argument, nullptr, 't'},
+        {"filter", required_argument, nullptr, 'f'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "t:f:h", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 't':
+            gMinTime = std::atof(optarg);
+            break;
+        case 'f':
+            gFilter = optarg;
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    WebCore::DenormalDisabler dd;
+
+    std::printf("stage,size,step,iterations,seconds,samples_per_second,ns_per_bin\n");
+
+    // first, as the other stages plan on configuration
+    benchPlanner();
+
+    benchStftBlock();
+    benchSmoother();
+
+    benchDownsampler<1>();
+    benchDownsampler<2>();
+    benchDownsampler<3>();
+    benchDownsampler<4>();
+    benchDownsampler<5>();
+    benchDownsampler<6>();
+    benchDownsampler<7>();
+
+    {
+        STFT stft;
+        benchAnalyzer("SteppingAnalyzer::process", stft);
+    }
+
+    benchMultirate<2>();
+    benchMultirate<3>();
+    benchMultirate<4>();
+    benchMultirate<5>();
+    benchMultirate<6>();
+    benchMultirate<7>();
+    benchMultirate<8>();
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "ui/components/SpectrumView.h"
+#include "plugin/ColorPalette.h"
+#include "Application.hpp"
+#include "TopLevelWidget.hpp"
+#include "Window.hpp"
+#include <getopt.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+///
+// Renders synthetic spectra in a window, and prints one CSV row per case:
+//   renderer,width,height,bins,frames,frame_us,spline_us,curve_us,grid_us,path_us,other_us
+// The times are averages per frame, `other` is the part of the frame outside
+// of the measured sections, like the flush of NanoVG and the buffer swap.
+//
+// It needs a display and OpenGL, on a headless machine use a virtual server
+// with software rendering, for instance:
+//   xvfb-run -s "-screen 0 1920x1080x24" env LIBGL_ALWAYS_SOFTWARE=1 <program>
+
+class BenchWidget : public TopLevelWidget {
+public:
+    explicit BenchWidget(Window &window)
+        : TopLevelWidget(window)
+    {
+    }
+
+protected:
+    void onDisplay() override
+    {
+    }
+};
+
+///
+class SyntheticSpectrum {
+public:
+    explicit SyntheticSpectrum(uint32_t windowSize, uint32_t numChannels)
+        : fNumBins(windowSize / 2 + 1),
+          fNumChannels(numChannels),
+          fFrequencies(fNumBins * numChannels),
+          fMagnitudes(fNumBins * numChannels)
+    {
+        const double sampleRate = 44100.0;
+        for (uint32_t c = 0; c < numChannels; ++c) {
+            for (uint32_t b = 0; b < fNumBins; ++b)
+                fFrequencies[c * fNumBins + b] = b * sampleRate / windowSize;
+        }
+    }
+
+    // a falling slope with noise and a few partials, different every frame
+    void nextFrame()
+    {
+        std::uniform_real_distribution<float> noise(-6.0f, 6.0f);
+        std::uniform_int_distribution<uint32_t> position(1, fNumBins - 1);
+
+        for (uint32_t c = 0; c < fNumChannels; ++c) {
+            const float *freqs = &fFrequencies[c * fNumBins];
+            float *mags = &fMagnitudes[c * fNumBins];
+            for (uint32_t b = 0; b < fNumBins; ++b)
+                mags[b] = -40.0f - 3.0f * std::log2(std::max(freqs[b], 20.0f) / 20.0f) + noise(fPrng);
+            for (uint32_t p = 0; p < 8; ++p)
+                mags[position(fPrng)] = -12.0f + noise(fPrng);
+        }
+    }
+
+    uint32_t getNumBins() const { return fNumBins; }
+    const float *getFrequencies() const { return fFrequencies.data(); }
+    const float *getMagnitudes() const { return fMagnitudes.data(); }
+
+private:
+    uint32_t fNumBins = 0;
+    uint32_t fNumChannels = 0;
+    std::vector<float> fFrequencies;
+    std::vector<float> fMagnitudes;
+    std::minstd_rand fPrng;
+};
+
+///
+static void usage()
+{
+    std::fprintf(stderr,
+        "Usage: spectacle-analyzer-bench-ui [options]\n"
+        "\n"
+        "Measures the display of the spectrum, and prints CSV.\n"
+        "\n"
+        "Options:\n"
+        "  -n, --frames=N  number of frames measured per case (default: 100)\n"
+        "  -h, --help      show this help\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t numFrames = 100;
+
+    static const struct option longOptions[] = {
+        {"frames", required_argument, nullptr, 'n'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "n:h", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'n':
+            numFrames = (uint32_t)std::max(1, std::atoi(optarg));
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    ///
+    typedef std::chrono::steady_clock clock;
+
+    const uint32_t numChannels = DISTRHO_PLUGIN_NUM_INPUTS;
+    const uint32_t windowSizes[] = {256, 1024, 4096, 16384};
+    const Size<uint> displaySizes[] = {{640, 360}, {1280, 720}, {1920, 1080}};
+    const uint32_t numWarmupFrames = 5;
+
+    const ColorPalette palette = ColorPalette::create_default();
+
+    Application app;
+    Window window(app);
+    BenchWidget top(window);
+    SpectrumView view(&top, palette);
+    view.setInterpolation(false);
+    window.setSize(displaySizes[0]);
+    window.show();
+
+    std::printf("renderer,width,height,bins,frames,frame_us,spline_us,curve_us,grid_us,path_us,other_us\n");
+
+    for (int renderer = 0; renderer < SpectrumView::kNumRenderers; ++renderer) {
+        view.setRenderer(renderer);
+
+        for (const Size<uint> &displaySize : displaySizes) {
+            window.setSize(displaySize);
+            view.setSize(displaySize);
+            for (uint32_t i = 0; i < numWarmupFrames; ++i)
+                app.idle();
+
+            for (uint32_t windowSize : windowSizes) {
+                SyntheticSpectrum spectrum(windowSize, numChannels);
+                SpectrumView::DisplayProfile profile;
+                double frameTime = 0;
+
+                for (uint32_t i = 0; i < numWarmupFrames + numFrames; ++i) {
+                    const bool measured = i >= numWarmupFrames;
+                    view.setDisplayProfile(measured ? &profile : nullptr);
+
+                    spectrum.nextFrame();
+                    view.setData(spectrum.getFrequencies(), spectrum.getMagnitudes(), spectrum.getNumBins(), numChannels);
+
+                    // the repaint which was requested happens during idle
+                    const clock::time_point t1 = clock::now();
+                    app.idle();
+                    const clock::time_point t2 = clock::now();
+
+                    if (measured)
+                        frameTime += std::chrono::duration<double>(t2 - t1).count();
+                }
+
+                view.setDisplayProfile(nullptr);
+
+                const uint32_t count = std::max(1u, profile.numFrames);
+                const double other = frameTime - profile.splineSetup - profile.curveEvaluation - profile.gridDrawing - profile.pathSubmission;
+                std::printf("%s,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                            SpectrumView::getRendererName(renderer),
+                            displaySize.getWidth(), displaySize.getHeight(),
+                            spectrum.getNumBins(), profile.numFrames,
+                            frameTime * 1e6 / count,
+                            profile.splineSetup * 1e6 / count,
+                            profile.curveEvaluation * 1e6 / count,
+                            profile.gridDrawing * 1e6 / count,
+                            profile.pathSubmission * 1e6 / count,
+                            other * 1e6 / count);
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include "dsp/STFT.h"
+#include "dsp/AnalyzerDefs.h"
+#include "blink/DenormalDisabler.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+///
+// Compares the analysis with its shortcuts against the analysis of every step:
+// the skipping of silent steps, and the decimation of the steps to the frame
+// interval, and checks that a silent channel stops making frames. Prints the
+// failures, and exits with a non-zero status if any.
+
+static constexpr double kSampleRate = 44100.0;
+static constexpr uint32_t kBlockSize = 512;
+
+static unsigned gFailures = 0;
+
+#define CHECK(cond, ...) do {                           \
+        if (!(cond)) {                                  \
+            std::fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            std::fprintf(stderr, __VA_ARGS__);          \
+            std::fprintf(stderr, "\n");                 \
+            ++gFailures;                                \
+        }                                               \
+    } while (0)
+
+static Configuration makeConfig(uint32_t windowSize, uint32_t stepSize)
+{
+    Configuration config;
+    config.windowSize = windowSize;
+    config.stepSize = stepSize;
+    config.sampleRate = kSampleRate;
+    return config;
+}
+
+static void addTone(std::vector<float> &signal, double start, double duration, double frequency, double amplitude)
+{
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> noise(-1e-3f, 1e-3f);
+
+    const size_t first = (size_t)(start * kSampleRate);
+    const size_t last = std::min(signal.size(), first + (size_t)(duration * kSampleRate));
+    for (size_t i = first; i < last; ++i)
+        signal[i] += (float)(amplitude * std::sin(2.0 * M_PI * frequency * i / kSampleRate)) + noise(prng);
+}
+
+static float getMaxDifference(const BasicAnalyzer &a, const BasicAnalyzer &b)
+{
+    float difference = 0;
+    for (uint32_t i = 0, n = a.getNumBins(); i < n; ++i)
+        difference = std::max(difference, std::fabs(a.getMagnitudes()[i] - b.getMagnitudes()[i]));
+    return difference;
+}
+
+///
+// Silent steps: the magnitudes decay in closed form, and stay once within
+// kNegligibleDB of the floor, instead of being analyzed.
+static void checkSilenceSkipping()
+{
+    // tone bursts between runs of digital silence, for 20 seconds
+    std::vector<float> signal((size_t)(20 * kSampleRate));
+    for (uint32_t burst = 0; burst < 4; ++burst)
+        addTone(signal, 5.0 * burst, 1.0, 1000.0, 0.5);
+
+    const uint32_t windowSizes[] = {256, 4096};
+    for (uint32_t windowSize : windowSizes) {
+        const Configuration config = makeConfig(windowSize, 64);
+        STFT skipping;
+        STFT reference;
+        skipping.configure(config);
+        reference.configure(config);
+        reference.setSilenceSkipping(false);
+        skipping.clear();
+        reference.clear();
+
+        // the silent steps of a block count as one frame, which is there
+        // whenever the reference has frames, until the silence settles
+        float maxDifference = 0;
+        bool framesTogether = true;
+        for (size_t i = 0; i + kBlockSize <= signal.size(); i += kBlockSize) {
+            const uint32_t skippingCounter = skipping.getFrameCounter();
+            const uint32_t referenceCounter = reference.getFrameCounter();
+            skipping.process(&signal[i], kBlockSize);
+            reference.process(&signal[i], kBlockSize);
+            framesTogether = framesTogether &&
+                (skipping.getFrameCounter() == skippingCounter || reference.getFrameCounter() != referenceCounter);
+            maxDifference = std::max(maxDifference, getMaxDifference(skipping, reference));
+        }
+        CHECK(framesTogether, "silence, window %u: a frame which the reference has not", windowSize);
+        CHECK(maxDifference < kNegligibleDB, "silence, window %u: %g dB apart", windowSize, maxDifference);
+        std::printf("silence skipping, window %u: at most %g dB apart\n", windowSize, maxDifference);
+    }
+}
+
+///
+// Silent channel with a frame interval: it has frames on the same steps as a
+// channel with signal while decaying, and none once settled.
+static void checkSilentChannel()
+{
+    std::vector<float> silence((size_t)(10 * kSampleRate));
+    std::vector<float> signal(silence.size());
+    addTone(signal, 0.0, 10.0, 1000.0, 0.5);
+
+    const uint32_t stepSize = 64;
+    const uint32_t interval = (uint32_t)(0.5 * kSampleRate / 60);
+    const Configuration config = makeConfig(1024, stepSize);
+
+    STFT silent;
+    STFT active;
+    silent.configure(config);
+    active.configure(config);
+    silent.setFrameInterval(interval);
+    active.setFrameInterval(interval);
+    silent.clear();
+    active.clear();
+
+    uint32_t numSilentFrames = 0;
+    uint32_t numActiveFrames = 0;
+    uint32_t lastSilentFrame = 0;
+    bool framesTogether = true;
+    // a step per block, to see each frame
+    const uint32_t numSteps = (uint32_t)(signal.size() / stepSize);
+    for (uint32_t step = 0; step < numSteps; ++step) {
+        const uint32_t silentCounter = silent.getFrameCounter();
+        const uint32_t activeCounter = active.getFrameCounter();
+        silent.process(&silence[step * stepSize], stepSize);
+        active.process(&signal[step * stepSize], stepSize);
+        const bool silentFrame = silent.getFrameCounter() != silentCounter;
+        const bool activeFrame = active.getFrameCounter() != activeCounter;
+        framesTogether = framesTogether && (!silentFrame || activeFrame);
+        numSilentFrames += silentFrame;
+        numActiveFrames += activeFrame;
+        if (silentFrame)
+            lastSilentFrame = step;
+    }
+
+    // the frames every interval at most, and the decay over the first seconds
+    const uint32_t maxFrames = (uint32_t)(signal.size() / (interval / stepSize * stepSize)) + 1;
+    CHECK(framesTogether, "silent channel: a frame off the steps of the other");
+    CHECK(numActiveFrames <= maxFrames, "silent channel: %u frames, more than %u", numActiveFrames, maxFrames);
+    CHECK(numSilentFrames < numActiveFrames, "silent channel: as many frames as with signal");
+    CHECK(lastSilentFrame < numSteps / 2, "silent channel: frames at step %u of %u", lastSilentFrame, numSteps);
+    std::printf("silent channel, frame interval of %u samples: %u frames against %u, the last at step %u of %u\n",
+                interval, numSilentFrames, numActiveFrames, lastSilentFrame, numSteps);
+}
+
+///
+// Frame interval: at most a step, every step is a frame, as with none.
+static void checkShortFrameInterval()
+{
+    std::vector<float> signal((size_t)(2 * kSampleRate));
+    addTone(signal, 0.0, 1.0, 1000.0, 0.5);
+    addTone(signal, 1.0, 1.0, 1000.0, 0.005);
+
+    const uint32_t stepSize = 256;
+    const uint32_t intervals[] = {1, stepSize - 1, stepSize};
+    for (uint32_t interval : intervals) {
+        const Configuration config = makeConfig(4096, stepSize);
+        STFT decimated;
+        STFT reference;
+        decimated.configure(config);
+        reference.configure(config);
+        decimated.setFrameInterval(interval);
+        decimated.clear();
+        reference.clear();
+
+        bool identical = true;
+        for (size_t i = 0; i + kBlockSize <= signal.size(); i += kBlockSize) {
+            decimated.process(&signal[i], kBlockSize);
+            reference.process(&signal[i], kBlockSize);
+            identical = identical && decimated.getFrameCounter() == reference.getFrameCounter() &&
+                !std::memcmp(decimated.getMagnitudes(), reference.getMagnitudes(), reference.getNumBins() * sizeof(float));
+        }
+        CHECK(identical, "interval %u: not identical to no interval", interval);
+    }
+    std::printf("frame interval up to a step: identical to none\n");
+}
+
+// Frame interval of several steps: the trajectory of a tone is the one of every
+// step, within a display frame of two intervals. The frame sees at once the
+// window which the steps went through one at a time, so it may lead as well as
+// lag. The check is on the bin of the tone only, since the others see one step
+// of the noise and the side lobes instead of all.
+static void checkLongFrameInterval()
+{
+    // a loud tone, a quieter one to release to, and the loud one again
+    std::vector<float> signal((size_t)(3 * kSampleRate));
+    addTone(signal, 0.0, 1.0, 1000.0, 0.5);
+    addTone(signal, 1.0, 1.0, 1000.0, 0.005);
+    addTone(signal, 2.0, 1.0, 1000.0, 0.5);
+
+    // as the plugin, two frames per refresh of a 60 Hz editor
+    const uint32_t stepSize = 64;
+    const uint32_t interval = (uint32_t)(0.5 * kSampleRate / 60);
+    const Configuration config = makeConfig(1024, stepSize);
+
+    STFT decimated;
+    STFT reference;
+    decimated.configure(config);
+    reference.configure(config);
+    decimated.setFrameInterval(interval);
+    decimated.clear();
+    reference.clear();
+
+    // the trajectory of the bin of the tone at every step, and the frames
+    const uint32_t toneBin = (uint32_t)std::lrint(1000.0 * config.windowSize / kSampleRate);
+    const uint32_t numSteps = (uint32_t)(signal.size() / stepSize);
+    std::vector<float> trajectory(numSteps);
+    std::vector<float> frames(numSteps, NAN);
+
+    for (uint32_t step = 0; step < numSteps; ++step) {
+        const uint32_t counter = decimated.getFrameCounter();
+        decimated.process(&signal[step * stepSize], stepSize);
+        reference.process(&signal[step * stepSize], stepSize);
+        trajectory[step] = reference.getMagnitudes()[toneBin];
+        if (decimated.getFrameCounter() != counter)
+            frames[step] = decimated.getMagnitudes()[toneBin];
+    }
+
+    const uint32_t displaySteps = 2 * interval / stepSize + 1;
+    uint32_t numFrames = 0;
+    float maxExcess = 0;
+    for (uint32_t step = displaySteps; step + displaySteps < numSteps; ++step) {
+        const float value = frames[step];
+        if (std::isnan(value))
+            continue;
+        ++numFrames;
+        const auto range = std::minmax_element(&trajectory[step - displaySteps], &trajectory[step + displaySteps + 1]);
+        maxExcess = std::max(maxExcess, std::max(*range.first - value, value - *range.second));
+    }
+    CHECK(numFrames > 0, "long interval: no frames");
+    CHECK(maxExcess < kNegligibleDB, "long interval: %g dB off the trajectory", maxExcess);
+    std::printf("frame interval of %u samples: %u frames, at most %g dB off the trajectory\n", interval, numFrames, maxExcess);
+}
+
+///
+int main()
+{
+    WebCore::DenormalDisabler dd;
+
+    checkSilenceSkipping();
+    checkSilentChannel();
+    checkShortFrameInterval();
+    checkLongFrameInterval();
+
+    if (gFailures > 0) {
+        std::fprintf(stderr, "%u failures\n", gFailures);
+        return 1;
+    }
+
+    std::printf("Analyzer checks passed\n");
+    return 0;
+}
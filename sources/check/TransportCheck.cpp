@@ -0,0 +1,230 @@
+#include "plugin/SpectrumTransport.h"
+#include "dsp/AnalyzerDefs.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cmath>
+
+///
+// Encodes frames with SpectrumEncoder, and checks that SpectrumDecoder gives
+// them back within half a quantization step, through the fragments, and that
+// it recovers at the next key frame from a frame which it missed.
+// Prints the failures, and exits with a non-zero status if any.
+
+static constexpr uint32_t kNumChannels = 2;
+
+static unsigned gFailures = 0;
+
+#define CHECK(cond, ...) do {                           \
+        if (!(cond)) {                                  \
+            std::fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            std::fprintf(stderr, __VA_ARGS__);          \
+            std::fprintf(stderr, "\n");                 \
+            ++gFailures;                                \
+        }                                               \
+    } while (0)
+
+static float getStep(CurveKind kind)
+{
+    return (kind == kCurveCoherence) ? (1.0f / 4096) : (1.0f / 16);
+}
+
+// the values which the encoder clamps come back at the bound, and a NaN at
+// the lower one
+static float getExpected(float value, float step)
+{
+    const float bound = (float)(1 << 20) * step;
+    return !(value > -bound) ? -bound : std::min(value, bound);
+}
+
+struct Frame {
+    ChannelMode mode = kChannelModeLeftRight;
+    uint32_t numBins = 0;
+    uint32_t numCurves = 0;
+    std::vector<float> frequencies;
+    std::vector<float> magnitudes;
+};
+
+static void makeFrame(Frame &frame, ChannelMode mode, uint32_t numBins, std::mt19937 &prng)
+{
+    frame.mode = mode;
+    frame.numBins = numBins;
+    frame.numCurves = getNumCurves(mode, kNumChannels);
+    frame.frequencies.resize(numBins);
+    frame.magnitudes.resize(frame.numCurves * numBins);
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (uint32_t i = 0; i < numBins; ++i)
+        frame.frequencies[i] = 22050.0f * i / numBins;
+
+    for (uint32_t c = 0; c < frame.numCurves; ++c) {
+        float *values = &frame.magnitudes[c * numBins];
+        for (uint32_t i = 0; i < numBins; ++i) {
+            switch (getCurveKind(mode, kNumChannels, c)) {
+            case kCurveMagnitude:
+                values[i] = -180.0f + 180.0f * unit(prng);
+                break;
+            case kCurveCoherence:
+                values[i] = unit(prng);
+                break;
+            case kCurvePhase:
+                values[i] = -180.0f + 360.0f * unit(prng);
+                break;
+            case kCurveGain:
+                values[i] = -60.0f + 120.0f * unit(prng);
+                break;
+            }
+        }
+    }
+}
+
+static bool sendFrame(SpectrumEncoder &encoder, SpectrumDecoder &decoder, const Frame &frame, uint32_t skipFragment = ~0u)
+{
+    if (!encoder.encode(frame.mode, frame.numBins, frame.numCurves, frame.frequencies.data(), frame.magnitudes.data()))
+        return false;
+
+    bool decoded = false;
+    const uint32_t numFragments = encoder.getNumFragments();
+    for (uint32_t i = 0; i < numFragments; ++i) {
+        const char *message = encoder.getFragment(i);
+        if (i != skipFragment)
+            decoded = decoder.receive(message);
+    }
+    return decoded;
+}
+
+static void compareFrame(const SpectrumDecoder &decoder, const Frame &frame, const char *what)
+{
+    CHECK(decoder.getChannelMode() == frame.mode, "%s: channel mode", what);
+    CHECK(decoder.getNumBins() == frame.numBins, "%s: bin count %u != %u", what, decoder.getNumBins(), frame.numBins);
+    CHECK(decoder.getNumCurves() == frame.numCurves, "%s: curve count", what);
+    if (decoder.getNumBins() != frame.numBins || decoder.getNumCurves() != frame.numCurves)
+        return;
+
+    for (uint32_t i = 0; i < frame.numBins; ++i) {
+        if (decoder.getFrequencies()[i] != frame.frequencies[i]) {
+            CHECK(false, "%s: frequency of bin %u", what, i);
+            break;
+        }
+    }
+
+    float maxError[4] = {};
+    for (uint32_t c = 0; c < frame.numCurves; ++c) {
+        const CurveKind kind = getCurveKind(frame.mode, kNumChannels, c);
+        const float step = getStep(kind);
+        for (uint32_t i = 0; i < frame.numBins; ++i) {
+            const uint32_t index = c * frame.numBins + i;
+            const float error = std::fabs(decoder.getMagnitudes()[index] - getExpected(frame.magnitudes[index], step));
+            maxError[kind] = std::max(maxError[kind], error / step);
+        }
+    }
+    for (float error : maxError)
+        CHECK(error <= 0.5f + 1e-3f, "%s: error of %g steps", what, error);
+}
+
+///
+static void checkRoundTrip()
+{
+    std::mt19937 prng;
+    const uint32_t maxBins = 3 * kFrameFragmentSize / 4;
+    const uint32_t maxCurves = kNumChannels + 3;
+
+    SpectrumEncoder encoder;
+    encoder.configure(kNumChannels, maxBins, maxCurves);
+    SpectrumDecoder decoder(kNumChannels);
+
+    // every mode, on bin counts which leave every remainder to the base64,
+    // and large enough to take several fragments
+    const uint32_t binCounts[] = {1, 2, 3, 129, 1025, maxBins};
+    for (uint32_t mode = 0; mode < kNumChannelModes; ++mode) {
+        for (uint32_t numBins : binCounts) {
+            Frame frame;
+            char what[64];
+            // the key frame, then the differences to it and to each other
+            for (uint32_t n = 0; n < 3; ++n) {
+                makeFrame(frame, (ChannelMode)mode, numBins, prng);
+                std::snprintf(what, sizeof(what), "mode %u, %u bins, frame %u", mode, numBins, n);
+                CHECK(sendFrame(encoder, decoder, frame), "%s: not decoded", what);
+                compareFrame(decoder, frame, what);
+            }
+        }
+    }
+}
+
+static void checkExtremes()
+{
+    const uint32_t numBins = 8;
+
+    SpectrumEncoder encoder;
+    encoder.configure(kNumChannels, numBins, kNumChannels);
+    SpectrumDecoder decoder(kNumChannels);
+
+    // the largest differences, between opposite bounds, and values which
+    // only clamp
+    const float values[][numBins] = {
+        {1e9f, -1e9f, 0.0f, -0.0f, 1e-9f, -1e-9f, 65535.0f, -65536.0f},
+        {-1e9f, 1e9f, 1e9f, -1e9f, NAN, INFINITY, -INFINITY, 0.03125f},
+    };
+
+    Frame frame;
+    frame.mode = kChannelModeLeftRight;
+    frame.numBins = numBins;
+    frame.numCurves = kNumChannels;
+    frame.frequencies.assign(numBins, 1000.0f);
+    for (const auto &row : values) {
+        frame.magnitudes.clear();
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            frame.magnitudes.insert(frame.magnitudes.end(), row, row + numBins);
+        CHECK(sendFrame(encoder, decoder, frame), "extremes: not decoded");
+        compareFrame(decoder, frame, "extremes");
+    }
+}
+
+static void checkRecovery()
+{
+    std::mt19937 prng;
+    const uint32_t numBins = kFrameFragmentSize / 2;
+
+    SpectrumEncoder encoder;
+    encoder.configure(kNumChannels, numBins, kNumChannels);
+    SpectrumDecoder decoder(kNumChannels);
+
+    Frame frame;
+    makeFrame(frame, kChannelModeLeftRight, numBins, prng);
+    CHECK(sendFrame(encoder, decoder, frame), "recovery: key frame not decoded");
+
+    // a frame of which a fragment is lost, and the difference which follows
+    // it, are dropped
+    makeFrame(frame, kChannelModeLeftRight, numBins, prng);
+    CHECK(!sendFrame(encoder, decoder, frame, 1), "recovery: incomplete frame decoded");
+    CHECK(encoder.getNumFragments() > 1, "recovery: a single fragment");
+    makeFrame(frame, kChannelModeLeftRight, numBins, prng);
+    CHECK(!sendFrame(encoder, decoder, frame), "recovery: frame after a missed one decoded");
+
+    encoder.requestKeyFrame();
+    makeFrame(frame, kChannelModeLeftRight, numBins, prng);
+    CHECK(sendFrame(encoder, decoder, frame), "recovery: next key frame not decoded");
+    compareFrame(decoder, frame, "recovery");
+
+    // garbage is rejected, and leaves the decoder waiting for a key frame
+    CHECK(!decoder.receive("0 1 @@@@"), "recovery: invalid text decoded");
+    CHECK(!decoder.receive("junk"), "recovery: invalid message decoded");
+}
+
+///
+int main()
+{
+    checkRoundTrip();
+    checkExtremes();
+    checkRecovery();
+
+    if (gFailures > 0) {
+        std::fprintf(stderr, "%u failures\n", gFailures);
+        return 1;
+    }
+
+    std::printf("Transport checks passed\n");
+    return 0;
+}
@@ -0,0 +1,532 @@
+#include "AudioFile.h"
+#include "dsp/SpectralAnalyzer.h"
+#include "dsp/AnalyzerFactory.h"
+#include "dsp/AnalyzerDefs.h"
+#include "blink/DenormalDisabler.h"
+#include <getopt.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cctype>
+#include <cerrno>
+
+enum OutputFormat {
+    kOutputCsv,
+    kOutputBinary,
+};
+
+struct Options {
+    const char *inputPath = nullptr;
+    const char *outputPath = nullptr;
+    OutputFormat outputFormat = kOutputCsv;
+    bool raw = false;
+    SampleFormat rawFormat = kSampleF32;
+    uint32_t rawChannels = 2;
+    double rawSampleRate = 44100;
+    Algorithm algorithm = kDefaultAlgorithm;
+    uint32_t windowSize = kStftDefaultSize;
+    uint32_t stepSize = kStftDefaultStep;
+    double attackTime = kStftDefaultAttackTime;
+    double releaseTime = kStftDefaultReleaseTime;
+    uint32_t numThreads = 0;
+    uint64_t segmentFrames = 1u << 20;
+};
+
+// the name of an algorithm as given on the command line, e.g. "stft-x2"
+static std::string getAlgorithmOption(Algorithm algorithm)
+{
+    std::string result = getAlgorithmName(algorithm);
+    for (char &c : result)
+        c = (c == ' ') ? '-' : (char)std::tolower((unsigned char)c);
+    return result;
+}
+
+static void usage()
+{
+    // the algorithms, wrapped under the option descriptions
+    std::string algorithms;
+    size_t lineStart = 0;
+    for (uint32_t algo = 0; algo < kNumAlgorithms; ++algo) {
+        std::string name = getAlgorithmOption((Algorithm)algo);
+        if (algo + 1 < kNumAlgorithms)
+            name.push_back(',');
+        if (algo == 0)
+            algorithms.append(25, ' ');
+        else if (algorithms.size() - lineStart + 1 + name.size() > 78) {
+            algorithms.push_back('\n');
+            lineStart = algorithms.size();
+            algorithms.append(25, ' ');
+        }
+        else
+            algorithms.push_back(' ');
+        algorithms.append(name);
+    }
+
+    std::fprintf(stderr,
+        "Usage: spectacle-analyzer-cli [options] <input>\n"
+        "\n"
+        "Analyzes an audio file and writes the spectra of successive frames.\n"
+        "\n"
+        "Options:\n"
+        "  -a, --algorithm=NAME   analysis algorithm (default: %s), one of:\n"
+        "%s\n"
+        "  -r, --resolution=N     analysis window size, power of 2 (default: %u)\n"
+        "  -s, --step=N           analysis step, power of 2 (default: %u)\n"
+        "      --attack=MS        attack time in milliseconds (default: %g)\n"
+        "      --release=MS       release time in milliseconds (default: %g)\n"
+        "  -f, --format=FORMAT    output format: csv, binary (default: csv)\n"
+        "  -o, --output=FILE      output file (default: standard output)\n"
+        "  -j, --jobs=N           number of threads (default: all processors)\n"
+        "      --segment=N        frames of input per parallel job (default: %llu)\n"
+        "      --raw=FORMAT       headerless input: u8, s16, s24, s32, f32, f64\n"
+        "      --channels=N       channel count of headerless input (default: 2)\n"
+        "      --rate=HZ          sample rate of headerless input (default: 44100)\n"
+        "  -h, --help             show this help\n"
+        "\n"
+        "The CSV output has a header row with the frequencies, then one row per\n"
+        "frame and channel: time, channel, magnitudes in dB.\n"
+        "\n"
+        "The binary output is in native byte order: the magic \"SPCL\", the\n"
+        "32-bit channel count and bin count, the 64-bit sample rate, the 32-bit\n"
+        "frequencies, then per frame the 64-bit time and 32-bit magnitudes of\n"
+        "each channel in turn.\n",
+        getAlgorithmOption(kDefaultAlgorithm).c_str(), algorithms.c_str(), kStftDefaultSize, kStftDefaultStep,
+        kStftDefaultAttackTime * 1e3, kStftDefaultReleaseTime * 1e3,
+        (unsigned long long)Options().segmentFrames);
+}
+
+static bool parseAlgorithm(const char *name, Algorithm &algorithm)
+{
+    // accept the display names, case and punctuation aside
+    auto simplify = [](const char *text) -> std::string {
+        std::string result;
+        for (; *text; ++text) {
+            if (std::isalnum((unsigned char)*text))
+                result.push_back(std::tolower((unsigned char)*text));
+        }
+        return result;
+    };
+
+    const std::string key = simplify(name);
+    for (uint32_t algo = 0; algo < kNumAlgorithms; ++algo) {
+        if (key == simplify(getAlgorithmName((Algorithm)algo))) {
+            algorithm = (Algorithm)algo;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parsePowerOfTwo(const char *text, uint32_t minimum, uint32_t maximum, uint32_t &value)
+{
+    char *end;
+    unsigned long number = std::strtoul(text, &end, 10);
+    if (*end != '\0' || number < minimum || number > maximum || (number & (number - 1)))
+        return false;
+    value = (uint32_t)number;
+    return true;
+}
+
+// how many times the slowest part of the analyzer decimates the input
+static uint32_t getDecimation(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case kAlgoStft: default:
+    case kAlgoSlidingDft:
+    case kAlgoReassignedStft:
+    case kAlgoMultitaper:
+        return 1;
+    case kAlgoMultirateStftX2:
+        return 1u << 1;
+    case kAlgoMultirateStftX3:
+        return 1u << 2;
+    case kAlgoMultirateStftX4:
+        return 1u << 3;
+    case kAlgoMultirateStftX5:
+        return 1u << 4;
+    case kAlgoMultirateStftX6:
+        return 1u << 5;
+    case kAlgoMultirateStftX7:
+        return 1u << 6;
+    case kAlgoMultirateStftX8:
+        return 1u << 7;
+    case kAlgoConstantQ:
+        // its kernel can need twice the resolution, at the lowest settings
+        return 2u << (kCqMaxOctaves - 1);
+    }
+}
+
+///
+// The input is cut in segments which are analyzed independently. Each one
+// starts earlier by a pre-roll, which fills the windows and lets the smoothing
+// settle, and whose frames are dropped; the pre-roll and the segments are
+// aligned on the analysis step, so all segments share the frame times of a
+// single pass over the file.
+class Analysis {
+public:
+    Analysis(const Options &opts, const AudioFile &file);
+    bool run(FILE *stream);
+
+private:
+    void writeHeader(std::string &out) const;
+    void writeFrame(std::string &out, double time, const std::unique_ptr<BasicAnalyzer> *analyzers) const;
+    void analyzeSegment(uint64_t index, std::unique_ptr<BasicAnalyzer> *analyzers, std::string &out) const;
+    void runWorker();
+
+private:
+    const Options &fOpts;
+    const AudioFile &fFile;
+    Configuration fConfig;
+    uint32_t fNumBins = 0;
+    std::vector<float> fFrequencies;
+    uint64_t fPreroll = 0;
+    uint64_t fSegmentFrames = 0;
+    uint64_t fNumSegments = 0;
+
+    // segments which are ready, written in order by the main thread
+    std::mutex fMutex;
+    std::condition_variable fCond;
+    std::vector<std::string> fResults;
+    std::vector<char> fDone;
+    uint64_t fNextSegment = 0;
+    uint64_t fNextWrite = 0;
+    uint64_t fMaxPending = 0;
+};
+
+Analysis::Analysis(const Options &opts, const AudioFile &file)
+    : fOpts(opts),
+      fFile(file)
+{
+    Configuration &config = fConfig;
+    config.windowSize = opts.windowSize;
+    config.stepSize = opts.stepSize;
+    config.attackTime = opts.attackTime;
+    config.releaseTime = opts.releaseTime;
+    config.sampleRate = file.getSampleRate();
+
+    // configure once ahead, it also plans the FFT before the threads start
+    std::unique_ptr<BasicAnalyzer> probe(createAnalyzer(opts.algorithm));
+    probe->configure(config);
+    fNumBins = probe->getNumBins();
+    fFrequencies.assign(probe->getFrequencies(), probe->getFrequencies() + fNumBins);
+
+    const uint64_t alignment = (uint64_t)opts.stepSize * getDecimation(opts.algorithm);
+    auto alignUp = [alignment](uint64_t x) -> uint64_t
+        { return (x + alignment - 1) / alignment * alignment; };
+
+    const double settleTime = 10.0 * std::max(opts.attackTime, opts.releaseTime);
+    fPreroll = alignUp((uint64_t)opts.windowSize * getDecimation(opts.algorithm) +
+                       (uint64_t)std::ceil(settleTime * config.sampleRate));
+    fSegmentFrames = alignUp(std::max(opts.segmentFrames, 4 * fPreroll));
+    fNumSegments = (file.getNumFrames() + fSegmentFrames - 1) / fSegmentFrames;
+}
+
+bool Analysis::run(FILE *stream)
+{
+    uint32_t numThreads = fOpts.numThreads;
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = (uint32_t)std::min<uint64_t>(numThreads, std::max<uint64_t>(1, fNumSegments));
+
+    fResults.resize(fNumSegments);
+    fDone.resize(fNumSegments);
+    fMaxPending = 2 * numThreads;
+
+    std::string header;
+    writeHeader(header);
+    bool ok = std::fwrite(header.data(), 1, header.size(), stream) == header.size();
+
+    std::vector<std::thread> threads(numThreads);
+    for (std::thread &thread : threads)
+        thread = std::thread([this]() { runWorker(); });
+
+    for (uint64_t index = 0; index < fNumSegments; ++index) {
+        std::string result;
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fCond.wait(lock, [this, index]() -> bool { return fDone[index]; });
+            result.swap(fResults[index]);
+            fNextWrite = index + 1;
+        }
+        fCond.notify_all();
+        if (ok)
+            ok = std::fwrite(result.data(), 1, result.size(), stream) == result.size();
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    return ok && std::fflush(stream) == 0;
+}
+
+void Analysis::runWorker()
+{
+    WebCore::DenormalDisabler dd;
+
+    const uint32_t numChannels = fFile.getNumChannels();
+    std::unique_ptr<std::unique_ptr<BasicAnalyzer>[]> analyzers(new std::unique_ptr<BasicAnalyzer>[numChannels]);
+    for (uint32_t c = 0; c < numChannels; ++c) {
+        analyzers[c].reset(createAnalyzer(fOpts.algorithm));
+        analyzers[c]->configure(fConfig);
+    }
+
+    for (;;) {
+        uint64_t index;
+        {
+            // do not run too far ahead of the writer, to bound the memory
+            std::unique_lock<std::mutex> lock(fMutex);
+            fCond.wait(lock, [this]() -> bool {
+                return fNextSegment >= fNumSegments || fNextSegment < fNextWrite + fMaxPending; });
+            if (fNextSegment >= fNumSegments)
+                break;
+            index = fNextSegment++;
+        }
+
+        std::string result;
+        analyzeSegment(index, analyzers.get(), result);
+
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fResults[index].swap(result);
+            fDone[index] = true;
+        }
+        fCond.notify_all();
+    }
+}
+
+void Analysis::analyzeSegment(uint64_t index, std::unique_ptr<BasicAnalyzer> *analyzers, std::string &out) const
+{
+    const AudioFile &file = fFile;
+    const uint32_t numChannels = file.getNumChannels();
+    const double sampleRate = file.getSampleRate();
+
+    const uint64_t segmentStart = index * fSegmentFrames;
+    const uint64_t segmentEnd = std::min(segmentStart + fSegmentFrames, file.getNumFrames());
+    const uint64_t runStart = (segmentStart > fPreroll) ? (segmentStart - fPreroll) : 0;
+
+    for (uint32_t c = 0; c < numChannels; ++c)
+        analyzers[c]->clear();
+
+    // one analysis step at most per block, each block can give a frame
+    const uint32_t blockSize = fConfig.stepSize;
+    std::vector<float> block(blockSize);
+
+    // the channels whose silence has settled make no frames, but keep their
+    // magnitudes; after the first frame, every block gives a row, as every
+    // step is a frame otherwise
+    const auto getFrameCounter = [analyzers, numChannels]() -> uint32_t {
+        uint32_t frameCounter = 0;
+        for (uint32_t c = 0; c < numChannels; ++c)
+            frameCounter += analyzers[c]->getFrameCounter();
+        return frameCounter;
+    };
+
+    const uint32_t firstFrameCounter = getFrameCounter();
+    bool haveFrame = false;
+    for (uint64_t pos = runStart; pos < segmentEnd; pos += blockSize) {
+        const uint32_t count = (uint32_t)std::min<uint64_t>(blockSize, segmentEnd - pos);
+        for (uint32_t c = 0; c < numChannels; ++c) {
+            file.readChannel(c, pos, count, block.data());
+            analyzers[c]->process(block.data(), count);
+        }
+
+        haveFrame = haveFrame || getFrameCounter() != firstFrameCounter;
+        if (haveFrame && pos + count > segmentStart)
+            writeFrame(out, (pos + count) / sampleRate, analyzers);
+    }
+}
+
+void Analysis::writeHeader(std::string &out) const
+{
+    const uint32_t numChannels = fFile.getNumChannels();
+    const uint32_t numBins = fNumBins;
+
+    if (fOpts.outputFormat == kOutputCsv) {
+        out.append("time,channel");
+        char number[64];
+        for (uint32_t b = 0; b < numBins; ++b) {
+            std::snprintf(number, sizeof(number), ",%.3f", fFrequencies[b]);
+            out.append(number);
+        }
+        out.push_back('\n');
+    }
+    else {
+        const double sampleRate = fFile.getSampleRate();
+        out.append("SPCL");
+        out.append((const char *)&numChannels, sizeof(uint32_t));
+        out.append((const char *)&numBins, sizeof(uint32_t));
+        out.append((const char *)&sampleRate, sizeof(double));
+        out.append((const char *)fFrequencies.data(), numBins * sizeof(float));
+    }
+}
+
+void Analysis::writeFrame(std::string &out, double time, const std::unique_ptr<BasicAnalyzer> *analyzers) const
+{
+    const uint32_t numChannels = fFile.getNumChannels();
+    const uint32_t numBins = fNumBins;
+
+    if (fOpts.outputFormat == kOutputCsv) {
+        char number[64];
+        for (uint32_t c = 0; c < numChannels; ++c) {
+            const float *mags = analyzers[c]->getMagnitudes();
+            std::snprintf(number, sizeof(number), "%.6f,%u", time, c + 1);
+            out.append(number);
+            for (uint32_t b = 0; b < numBins; ++b) {
+                std::snprintf(number, sizeof(number), ",%.2f", mags[b]);
+                out.append(number);
+            }
+            out.push_back('\n');
+        }
+    }
+    else {
+        out.append((const char *)&time, sizeof(double));
+        for (uint32_t c = 0; c < numChannels; ++c)
+            out.append((const char *)analyzers[c]->getMagnitudes(), numBins * sizeof(float));
+    }
+}
+
+///
+int main(int argc, char *argv[])
+{
+    Options opts;
+
+    enum {
+        kOptAttack = 256,
+        kOptRelease,
+        kOptSegment,
+        kOptRaw,
+        kOptChannels,
+        kOptRate,
+    };
+
+    static const struct option longOptions[] = {
+        {"algorithm", required_argument, nullptr, 'a'},
+        {"resolution", required_argument, nullptr, 'r'},
+        {"step", required_argument, nullptr, 's'},
+        {"attack", required_argument, nullptr, kOptAttack},
+        {"release", required_argument, nullptr, kOptRelease},
+        {"format", required_argument, nullptr, 'f'},
+        {"output", required_argument, nullptr, 'o'},
+        {"jobs", required_argument, nullptr, 'j'},
+        {"segment", required_argument, nullptr, kOptSegment},
+        {"raw", required_argument, nullptr, kOptRaw},
+        {"channels", required_argument, nullptr, kOptChannels},
+        {"rate", required_argument, nullptr, kOptRate},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "a:r:s:f:o:j:h", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'a':
+            if (!parseAlgorithm(optarg, opts.algorithm)) {
+                std::fprintf(stderr, "Invalid algorithm: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            if (!parsePowerOfTwo(optarg, kStftMinSize, kStftMaxSize, opts.windowSize)) {
+                std::fprintf(stderr, "Invalid resolution: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            if (!parsePowerOfTwo(optarg, kStftMinStep, kStftMaxStep, opts.stepSize)) {
+                std::fprintf(stderr, "Invalid step: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case kOptAttack:
+            opts.attackTime = std::max(kStftMinAttackTime, std::min(kStftMaxAttackTime, 1e-3 * std::atof(optarg)));
+            break;
+        case kOptRelease:
+            opts.releaseTime = std::max(kStftMinReleaseTime, std::min(kStftMaxReleaseTime, 1e-3 * std::atof(optarg)));
+            break;
+        case 'f':
+            if (!std::strcmp(optarg, "csv"))
+                opts.outputFormat = kOutputCsv;
+            else if (!std::strcmp(optarg, "binary"))
+                opts.outputFormat = kOutputBinary;
+            else {
+                std::fprintf(stderr, "Invalid output format: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            opts.outputPath = optarg;
+            break;
+        case 'j':
+            opts.numThreads = (uint32_t)std::max(0, std::atoi(optarg));
+            break;
+        case kOptSegment:
+            opts.segmentFrames = std::max(1ull, std::strtoull(optarg, nullptr, 10));
+            break;
+        case kOptRaw:
+            opts.raw = true;
+            if (!parseSampleFormat(optarg, opts.rawFormat)) {
+                std::fprintf(stderr, "Invalid sample format: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case kOptChannels:
+            opts.rawChannels = (uint32_t)std::max(0, std::atoi(optarg));
+            break;
+        case kOptRate:
+            opts.rawSampleRate = std::atof(optarg);
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if (argc - optind != 1) {
+        usage();
+        return 1;
+    }
+    opts.inputPath = argv[optind];
+
+    ///
+    AudioFile file;
+    std::string error;
+    bool opened = opts.raw ?
+        file.openRaw(opts.inputPath, opts.rawFormat, opts.rawChannels, opts.rawSampleRate, error) :
+        file.openWav(opts.inputPath, error);
+    if (!opened) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", opts.inputPath, error.c_str());
+        return 1;
+    }
+
+    FILE *stream = stdout;
+    if (opts.outputPath) {
+        stream = std::fopen(opts.outputPath, (opts.outputFormat == kOutputBinary) ? "wb" : "w");
+        if (!stream) {
+            std::fprintf(stderr, "Cannot open %s: %s\n", opts.outputPath, std::strerror(errno));
+            return 1;
+        }
+    }
+
+    Analysis analysis(opts, file);
+    bool ok = analysis.run(stream);
+
+    if (stream != stdout)
+        ok = std::fclose(stream) == 0 && ok;
+
+    if (!ok) {
+        std::fprintf(stderr, "Cannot write the output\n");
+        return 1;
+    }
+
+    return 0;
+}
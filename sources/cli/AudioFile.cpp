@@ -0,0 +1,245 @@
+#include "AudioFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+static uint32_t getSampleSize(SampleFormat format)
+{
+    switch (format) {
+    case kSampleU8:
+        return 1;
+    case kSampleS16: default:
+        return 2;
+    case kSampleS24:
+        return 3;
+    case kSampleS32: case kSampleF32:
+        return 4;
+    case kSampleF64:
+        return 8;
+    }
+}
+
+bool parseSampleFormat(const char *name, SampleFormat &format)
+{
+    static const struct { const char *name; SampleFormat format; } formats[] = {
+        {"u8", kSampleU8},
+        {"s16", kSampleS16},
+        {"s24", kSampleS24},
+        {"s32", kSampleS32},
+        {"f32", kSampleF32},
+        {"f64", kSampleF64},
+    };
+
+    for (const auto &f : formats) {
+        if (!std::strcmp(name, f.name)) {
+            format = f.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint16_t readU16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t readU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+///
+AudioFile::~AudioFile()
+{
+    close();
+}
+
+bool AudioFile::openWav(const char *path, std::string &error)
+{
+    if (!mapFile(path, error))
+        return false;
+
+    const uint8_t *file = fMapping;
+    const size_t fileSize = fMappingSize;
+
+    if (fileSize < 12 || std::memcmp(file, "RIFF", 4) || std::memcmp(file + 8, "WAVE", 4)) {
+        error = "not a WAVE file";
+        close();
+        return false;
+    }
+
+    const uint8_t *fmt = nullptr;
+    size_t dataOffset = 0;
+    size_t dataSize = 0;
+
+    for (size_t pos = 12; pos + 8 <= fileSize && dataOffset == 0;) {
+        const uint8_t *chunk = file + pos;
+        size_t chunkSize = readU32(chunk + 4);
+        pos += 8;
+        if (!std::memcmp(chunk, "fmt ", 4) && chunkSize >= 16 && pos + chunkSize <= fileSize)
+            fmt = file + pos;
+        else if (!std::memcmp(chunk, "data", 4)) {
+            // recorders which were interrupted can leave an invalid size
+            dataOffset = pos;
+            dataSize = std::min(chunkSize, fileSize - pos);
+        }
+        pos += chunkSize + (chunkSize & 1);
+    }
+
+    if (!fmt || dataOffset == 0) {
+        error = "the WAVE file has no audio data";
+        close();
+        return false;
+    }
+
+    uint32_t audioFormat = readU16(fmt);
+    const uint32_t numChannels = readU16(fmt + 2);
+    const uint32_t sampleRate = readU32(fmt + 4);
+    const uint32_t bitsPerSample = readU16(fmt + 14);
+
+    // WAVE_FORMAT_EXTENSIBLE, the actual format is the start of the GUID
+    if (audioFormat == 0xfffe && readU32(fmt - 4) >= 26)
+        audioFormat = readU16(fmt + 24);
+
+    SampleFormat format;
+    if (audioFormat == 1 && bitsPerSample == 8)
+        format = kSampleU8;
+    else if (audioFormat == 1 && bitsPerSample == 16)
+        format = kSampleS16;
+    else if (audioFormat == 1 && bitsPerSample == 24)
+        format = kSampleS24;
+    else if (audioFormat == 1 && bitsPerSample == 32)
+        format = kSampleS32;
+    else if (audioFormat == 3 && bitsPerSample == 32)
+        format = kSampleF32;
+    else if (audioFormat == 3 && bitsPerSample == 64)
+        format = kSampleF64;
+    else {
+        error = "unsupported WAVE sample format";
+        close();
+        return false;
+    }
+
+    return setLayout(format, numChannels, sampleRate, dataOffset, dataSize, error);
+}
+
+bool AudioFile::openRaw(const char *path, SampleFormat format, uint32_t numChannels, double sampleRate, std::string &error)
+{
+    if (!mapFile(path, error))
+        return false;
+
+    return setLayout(format, numChannels, sampleRate, 0, fMappingSize, error);
+}
+
+void AudioFile::close()
+{
+    if (fMapping)
+        munmap((void *)fMapping, fMappingSize);
+
+    fMapping = nullptr;
+    fMappingSize = 0;
+    fData = nullptr;
+    fNumChannels = 0;
+    fNumFrames = 0;
+}
+
+bool AudioFile::mapFile(const char *path, std::string &error)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        error = std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        error = "the file is empty";
+        ::close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    // the file is read front to back, although by several threads at once
+    madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+    fMapping = (const uint8_t *)mapping;
+    fMappingSize = st.st_size;
+    return true;
+}
+
+bool AudioFile::setLayout(SampleFormat format, uint32_t numChannels, double sampleRate, size_t dataOffset, size_t dataSize, std::string &error)
+{
+    if (numChannels == 0 || sampleRate <= 0) {
+        error = "invalid channel count or sample rate";
+        close();
+        return false;
+    }
+
+    fFormat = format;
+    fSampleSize = getSampleSize(format);
+    fFrameSize = fSampleSize * numChannels;
+    fNumChannels = numChannels;
+    fSampleRate = sampleRate;
+    fData = fMapping + dataOffset;
+    fNumFrames = dataSize / fFrameSize;
+    return true;
+}
+
+void AudioFile::readChannel(uint32_t channel, uint64_t start, uint32_t count, float *output) const
+{
+    const uint32_t frameSize = fFrameSize;
+    const uint8_t *p = fData + start * frameSize + channel * fSampleSize;
+
+    switch (fFormat) {
+    case kSampleU8:
+        for (uint32_t i = 0; i < count; ++i, p += frameSize)
+            output[i] = (int(p[0]) - 128) * (1.0f / 128);
+        break;
+    case kSampleS16:
+        for (uint32_t i = 0; i < count; ++i, p += frameSize)
+            output[i] = (int16_t)readU16(p) * (1.0f / 32768);
+        break;
+    case kSampleS24:
+        for (uint32_t i = 0; i < count; ++i, p += frameSize)
+            output[i] = (int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) * (1.0f / 2147483648.0f);
+        break;
+    case kSampleS32:
+        for (uint32_t i = 0; i < count; ++i, p += frameSize)
+            output[i] = (int32_t)readU32(p) * (1.0f / 2147483648.0f);
+        break;
+    case kSampleF32:
+        for (uint32_t i = 0; i < count; ++i, p += frameSize) {
+            float value;
+            std::memcpy(&value, p, sizeof(float));
+            output[i] = value;
+        }
+        break;
+    case kSampleF64:
+        for (uint32_t i = 0; i < count; ++i, p += frameSize) {
+            double value;
+            std::memcpy(&value, p, sizeof(double));
+            output[i] = (float)value;
+        }
+        break;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+enum SampleFormat {
+    kSampleU8,
+    kSampleS16,
+    kSampleS24,
+    kSampleS32,
+    kSampleF32,
+    kSampleF64,
+};
+
+bool parseSampleFormat(const char *name, SampleFormat &format);
+
+///
+// A file of interleaved little-endian PCM, mapped in memory. The samples are
+// decoded on request, so independent parts can be read by several threads.
+class AudioFile {
+public:
+    AudioFile() = default;
+    ~AudioFile();
+
+    AudioFile(const AudioFile &) = delete;
+    AudioFile &operator=(const AudioFile &) = delete;
+
+    bool openWav(const char *path, std::string &error);
+    bool openRaw(const char *path, SampleFormat format, uint32_t numChannels, double sampleRate, std::string &error);
+    void close();
+
+    uint64_t getNumFrames() const { return fNumFrames; }
+    uint32_t getNumChannels() const { return fNumChannels; }
+    double getSampleRate() const { return fSampleRate; }
+
+    // decodes a range of frames of one channel, in the range [-1, 1]
+    void readChannel(uint32_t channel, uint64_t start, uint32_t count, float *output) const;
+
+private:
+    bool mapFile(const char *path, std::string &error);
+    bool setLayout(SampleFormat format, uint32_t numChannels, double sampleRate, size_t dataOffset, size_t dataSize, std::string &error);
+
+private:
+    const uint8_t *fMapping = nullptr;
+    size_t fMappingSize = 0;
+
+    const uint8_t *fData = nullptr;
+    SampleFormat fFormat = kSampleS16;
+    uint32_t fSampleSize = 0;
+    uint32_t fFrameSize = 0;
+    uint32_t fNumChannels = 0;
+    uint64_t fNumFrames = 0;
+    double fSampleRate = 0;
+};
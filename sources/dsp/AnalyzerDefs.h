@@ -10,6 +10,10 @@ enum Algorithm {
     kAlgoMultirateStftX6,
     kAlgoMultirateStftX7,
     kAlgoMultirateStftX8,
+    kAlgoConstantQ,
+    kAlgoSlidingDft,
+    kAlgoReassignedStft,
+    kAlgoMultitaper,
     kNumAlgorithms,
 };
 
@@ -34,6 +38,122 @@ inline const char *getAlgorithmName(Algorithm a)
         return "STFT x7";
     case kAlgoMultirateStftX8:
         return "STFT x8";
+    case kAlgoConstantQ:
+        return "Constant-Q";
+    case kAlgoSlidingDft:
+        return "Sliding DFT";
+    case kAlgoReassignedStft:
+        return "Reassigned";
+    case kAlgoMultitaper:
+        return "Multitaper";
+    }
+}
+
+enum ChannelMode {
+    kChannelModeLeftRight,
+    kChannelModeCoherence,
+    kChannelModeTransfer,
+    kChannelModeMidSide,
+    kChannelModeLeftRightMidSide,
+    kNumChannelModes,
+};
+
+static constexpr ChannelMode kDefaultChannelMode = kChannelModeLeftRight;
+
+inline const char *getChannelModeName(ChannelMode m)
+{
+    switch (m) {
+    case kChannelModeLeftRight: default:
+        return "L/R";
+    case kChannelModeCoherence:
+        return "Coherence";
+    case kChannelModeTransfer:
+        return "Transfer";
+    case kChannelModeMidSide:
+        return "M/S";
+    case kChannelModeLeftRightMidSide:
+        return "L/R + M/S";
+    }
+}
+
+// whether a mode averages the cross-spectra of the first two channels
+inline bool hasCrossSpectrum(ChannelMode m)
+{
+    return m == kChannelModeCoherence || m == kChannelModeTransfer;
+}
+
+// whether a mode shows the mid and side of the first two channels
+inline bool hasMidSide(ChannelMode m)
+{
+    return m == kChannelModeMidSide || m == kChannelModeLeftRightMidSide;
+}
+
+// the quantity represented by a curve of per-bin values
+enum CurveKind {
+    kCurveMagnitude, // decibels
+    kCurveCoherence, // from 0 to 1
+    kCurvePhase, // degrees, from -180 to 180
+    kCurveGain, // decibels, relative to the first channel
+};
+
+// the signal whose magnitude a curve shows
+enum CurveSignal {
+    kSignalChannel, // the channel of the same index as the curve
+    kSignalMid,
+    kSignalSide,
+};
+
+// the curves of each channel mode: the magnitudes of the channels, except in
+// the M/S mode which replaces them, followed by the quantities between the
+// first two channels
+inline uint32_t getNumCurves(ChannelMode m, uint32_t numChannels)
+{
+    switch (m) {
+    case kChannelModeLeftRight: default:
+        return numChannels;
+    case kChannelModeCoherence:
+        return numChannels + 2;
+    case kChannelModeTransfer:
+        return numChannels + 3;
+    case kChannelModeMidSide:
+        return 2;
+    case kChannelModeLeftRightMidSide:
+        return numChannels + 2;
+    }
+}
+
+inline CurveKind getCurveKind(ChannelMode m, uint32_t numChannels, uint32_t curve)
+{
+    if (curve < numChannels)
+        return kCurveMagnitude;
+
+    switch (m) {
+    case kChannelModeLeftRight: default:
+    case kChannelModeMidSide:
+    case kChannelModeLeftRightMidSide:
+        return kCurveMagnitude;
+    case kChannelModeCoherence: {
+        const CurveKind kinds[] = {kCurveCoherence, kCurvePhase};
+        return kinds[curve - numChannels];
+    }
+    case kChannelModeTransfer: {
+        const CurveKind kinds[] = {kCurveGain, kCurveCoherence, kCurvePhase};
+        return kinds[curve - numChannels];
+    }
+    }
+}
+
+inline CurveSignal getCurveSignal(ChannelMode m, uint32_t numChannels, uint32_t curve)
+{
+    switch (m) {
+    default:
+        return kSignalChannel;
+    case kChannelModeMidSide:
+        return (curve == 0) ? kSignalMid : kSignalSide;
+    case kChannelModeLeftRightMidSide:
+        if (curve < numChannels)
+            return kSignalChannel;
+        return (curve == numChannels) ? kSignalMid : kSignalSide;
     }
 }
 
@@ -67,4 +187,11 @@ static constexpr double kStftDefaultReleaseTime = 250e-3;
 static constexpr double kStftFloorMagnitude = 1e-9;
 static constexpr double kStftFloorMagnitudeInDB = -180.0;
 
+// samples smaller than this cannot raise any bin of the window above the floor:
+// with window weights of at most 1, scaled by 2/N, a bin is at most 2 max|x|
+static constexpr double kStftSilenceThreshold = 0.5 * kStftFloorMagnitude;
+
 static constexpr double kNegligibleDB = 0.01;
+
+// the constant-Q transform decimates by 2 for each octave under the top one
+static constexpr uint32_t kCqMaxOctaves = 10;
@@ -0,0 +1,37 @@
+#include "AnalyzerFactory.h"
+#include "STFT.h"
+#include "MultirateSTFT.h"
+#include "ConstantQ.h"
+#include "SlidingDFT.h"
+#include "ReassignedSTFT.h"
+#include "Multitaper.h"
+
+BasicAnalyzer *createAnalyzer(Algorithm algo)
+{
+    switch (algo) {
+    case kAlgoStft: default:
+        return new STFT;
+    case kAlgoMultirateStftX2:
+        return new MultirateSTFT<2>;
+    case kAlgoMultirateStftX3:
+        return new MultirateSTFT<3>;
+    case kAlgoMultirateStftX4:
+        return new MultirateSTFT<4>;
+    case kAlgoMultirateStftX5:
+        return new MultirateSTFT<5>;
+    case kAlgoMultirateStftX6:
+        return new MultirateSTFT<6>;
+    case kAlgoMultirateStftX7:
+        return new MultirateSTFT<7>;
+    case kAlgoMultirateStftX8:
+        return new MultirateSTFT<8>;
+    case kAlgoConstantQ:
+        return new ConstantQ;
+    case kAlgoSlidingDft:
+        return new SlidingDFT;
+    case kAlgoReassignedStft:
+        return new ReassignedSTFT;
+    case kAlgoMultitaper:
+        return new Multitaper;
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include "AnalyzerDefs.h"
+class BasicAnalyzer;
+
+///
+// Creates an unconfigured analyzer which implements the given algorithm.
+BasicAnalyzer *createAnalyzer(Algorithm algo);
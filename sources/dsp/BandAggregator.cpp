@@ -0,0 +1,123 @@
+#include "BandAggregator.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+#include <cmath>
+
+// the bins of a Hann window overlap, so that a sum of their powers counts a
+// sinusoid 1.5 times, its equivalent noise bandwidth in bins
+static constexpr double kHannEnbw = 1.5;
+
+static constexpr double kMinBandFrequency = 20.0;
+static constexpr double kReferenceBandFrequency = 1000.0;
+
+void BandAggregator::configure(const float *frequencies, uint32_t numBins, uint32_t bandsPerOctave)
+{
+    _bandsPerOctave = bandsPerOctave;
+    _binFrequencies.assign(frequencies, frequencies + numBins);
+    _bandFrequencies.clear();
+    _rowStart.assign(1, 0);
+    _columns.clear();
+    _weights.clear();
+    _binRange[0] = _binRange[1] = 0;
+    _powers.resize(numBins);
+
+    if (bandsPerOctave == 0 || numBins < 2)
+        return;
+
+    // the span of each bin reaches the middle of its neighbors
+    auto binLower = [frequencies](uint32_t b) -> double {
+        return (b > 0) ? 0.5 * (frequencies[b - 1] + frequencies[b]) :
+            std::max(0.0, 1.5 * frequencies[0] - 0.5 * frequencies[1]);
+    };
+    auto binUpper = [frequencies, numBins](uint32_t b) -> double {
+        return (b + 1 < numBins) ? 0.5 * (frequencies[b] + frequencies[b + 1]) :
+            1.5 * frequencies[b] - 0.5 * frequencies[b - 1];
+    };
+
+    // bands which are entirely inside the frequency range
+    const double halfBand = std::exp2(0.5 / bandsPerOctave);
+    const double maxFrequency = frequencies[numBins - 1];
+    const int firstBand = (int)std::ceil(bandsPerOctave * std::log2(kMinBandFrequency / kReferenceBandFrequency));
+    const int lastBand = (int)std::floor(bandsPerOctave * std::log2(maxFrequency / halfBand / kReferenceBandFrequency));
+
+    uint32_t minBin = numBins;
+    uint32_t maxBin = 0;
+
+    for (int band = firstBand; band <= lastBand; ++band) {
+        const double center = kReferenceBandFrequency * std::exp2((double)band / bandsPerOctave);
+        const double lower = center / halfBand;
+        const double upper = center * halfBand;
+
+        // first bin whose span ends above the band lower edge
+        uint32_t b = (uint32_t)(std::lower_bound(frequencies, frequencies + numBins, (float)lower) - frequencies);
+        b = (b > 0) ? (b - 1) : 0;
+
+        for (; b < numBins; ++b) {
+            const double binLo = binLower(b);
+            const double binHi = binUpper(b);
+            if (binLo >= upper)
+                break;
+            const double overlap = std::min(upper, binHi) - std::max(lower, binLo);
+            if (overlap <= 0 || binHi <= binLo)
+                continue;
+            _columns.push_back(b);
+            _weights.push_back((float)(overlap / (binHi - binLo) / kHannEnbw));
+            minBin = std::min(minBin, b);
+            maxBin = std::max(maxBin, b);
+        }
+
+        _bandFrequencies.push_back((float)center);
+        _rowStart.push_back((uint32_t)_columns.size());
+    }
+
+    if (minBin <= maxBin) {
+        _binRange[0] = minBin;
+        _binRange[1] = maxBin + 1;
+    }
+}
+
+bool BandAggregator::isConfiguredFor(const float *frequencies, uint32_t numBins, uint32_t bandsPerOctave) const
+{
+    return _bandsPerOctave == bandsPerOctave && _binFrequencies.size() == numBins &&
+        std::equal(frequencies, frequencies + numBins, _binFrequencies.begin());
+}
+
+void BandAggregator::process(const float *binMagnitudes, float *bandMagnitudes)
+{
+    const uint32_t numBands = getNumBands();
+    const uint32_t *rowStart = _rowStart.data();
+    const uint32_t *columns = _columns.data();
+    const float *weights = _weights.data();
+    float *powers = _powers.data();
+
+    // decibels to powers, only for the bins in use
+    const float dBToLogPower = (float)(M_LN10 / 10.0);
+    for (uint32_t b = _binRange[0], end = _binRange[1]; b < end; ++b)
+        powers[b] = std::exp(dBToLogPower * binMagnitudes[b]);
+
+    const float floorPower = (float)(kStftFloorMagnitude * kStftFloorMagnitude);
+    for (uint32_t i = 0; i < numBands; ++i) {
+        float sum = 0;
+        for (uint32_t j = rowStart[i], end = rowStart[i + 1]; j < end; ++j)
+            sum += weights[j] * powers[columns[j]];
+        bandMagnitudes[i] = 10.0f * std::log10(std::max(floorPower, sum));
+    }
+}
+
+void BandAggregator::processLinear(const float *binValues, float *bandValues)
+{
+    const uint32_t numBands = getNumBands();
+    const uint32_t *rowStart = _rowStart.data();
+    const uint32_t *columns = _columns.data();
+    const float *weights = _weights.data();
+
+    for (uint32_t i = 0; i < numBands; ++i) {
+        float sum = 0;
+        float weightSum = 0;
+        for (uint32_t j = rowStart[i], end = rowStart[i + 1]; j < end; ++j) {
+            sum += weights[j] * binValues[columns[j]];
+            weightSum += weights[j];
+        }
+        bandValues[i] = (weightSum > 0) ? (sum / weightSum) : 0.0f;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+///
+// Aggregation of spectral bins into fractional-octave bands, centered on
+// 1 kHz in base 2. A band's power is the weighted sum of the powers of the
+// bins, weighted by the part of each bin's span inside the band. The weights
+// are computed once per frequency grid, and kept as a sparse matrix in CSR
+// form, one row per band.
+class BandAggregator {
+public:
+    void configure(const float *frequencies, uint32_t numBins, uint32_t bandsPerOctave);
+    bool isConfiguredFor(const float *frequencies, uint32_t numBins, uint32_t bandsPerOctave) const;
+
+    uint32_t getNumBands() const { return (uint32_t)_bandFrequencies.size(); }
+    const float *getBandFrequencies() const { return _bandFrequencies.data(); }
+
+    // converts bin magnitudes into band magnitudes, both in decibels
+    void process(const float *binMagnitudes, float *bandMagnitudes);
+
+    // converts bin values of another kind, such as a coherence, into their
+    // mean over each band, with the same weights
+    void processLinear(const float *binValues, float *bandValues);
+
+private:
+    uint32_t _bandsPerOctave = 0;
+    std::vector<float> _binFrequencies;
+    std::vector<float> _bandFrequencies;
+
+    // sparse matrix of weights, `_rowStart` having an extra end element
+    std::vector<uint32_t> _rowStart;
+    std::vector<uint32_t> _columns;
+    std::vector<float> _weights;
+
+    // range of the bins which contribute to any band
+    uint32_t _binRange[2] = { 0u, 0u };
+
+    // temporary
+    std::vector<float> _powers;
+};
@@ -0,0 +1,324 @@
+#include "ConstantQ.h"
+#include "FFTPlanner.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+#include <cmath>
+
+// kernel coefficients under this fraction of the largest of their row are
+// dropped, as the spectral kernel of a windowed sinusoid decays quickly
+static constexpr float kKernelThreshold = 0.0054f;
+
+// the top octave ends under this fraction of the sample rate
+static constexpr double kTopFrequencyRatio = 0.45;
+
+// the bins are on a grid tuned to this frequency
+static constexpr double kTuningFrequency = 440.0;
+
+// a frequency resolution per octave, each increasing the needed FFT size
+static constexpr uint32_t kBinsPerOctaveChoices[] = {12, 24, 36, 48, 72, 96};
+
+static constexpr double kLowestFrequency = 20.0;
+
+///
+void ConstantQKernel::configure(uint32_t fftSize, uint32_t binsPerOctave, double lowestFrequency)
+{
+    this->fftSize = fftSize;
+    numBins = binsPerOctave;
+    frequencies.resize(binsPerOctave);
+    rowStart.assign(1, 0);
+    columns.clear();
+    weights.clear();
+
+    const uint32_t numFftBins = fftSize / 2 + 1;
+    const double q = 1.0 / (std::exp2(1.0 / binsPerOctave) - 1.0);
+
+    fftwf_plan plan = FFTPlanner::getInstance().forwardFFT(fftSize);
+    fftwf_real_vector real(fftSize);
+    fftwf_real_vector imag(fftSize);
+    fftwf_complex_vector realSpectrum(numFftBins);
+    fftwf_complex_vector imagSpectrum(numFftBins);
+    std::vector<std::complex<float>> row(numFftBins);
+
+    for (uint32_t k = 0; k < binsPerOctave; ++k) {
+        const double frequency = lowestFrequency * std::exp2((double)k / binsPerOctave);
+        frequencies[k] = (float)frequency;
+
+        // the temporal kernel: a Hann-windowed complex sinusoid, Q periods
+        // long, centered in the block; scaled like the STFT's magnitudes
+        const uint32_t length = std::min(fftSize, (uint32_t)std::ceil(q / frequency));
+        const uint32_t offset = (fftSize - length) / 2;
+        std::fill(real.begin(), real.end(), 0.0f);
+        std::fill(imag.begin(), imag.end(), 0.0f);
+        for (uint32_t n = 0; n < length; ++n) {
+            const double window = 0.5 * (1.0 - std::cos(2.0 * M_PI * n / (length - 1)));
+            const double scale = 2.0 * window / length;
+            const double phase = 2.0 * M_PI * frequency * n;
+            real[offset + n] = (float)(scale * std::cos(phase));
+            imag[offset + n] = (float)(scale * std::sin(phase));
+        }
+
+        // its spectrum from the transforms of the real and imaginary parts;
+        // it's concentrated on positive frequencies, the others are dropped
+        fftwf_execute_dft_r2c(plan, real.data(), (fftwf_complex *)realSpectrum.data());
+        fftwf_execute_dft_r2c(plan, imag.data(), (fftwf_complex *)imagSpectrum.data());
+
+        float maxMagnitude = 0;
+        for (uint32_t j = 0; j < numFftBins; ++j) {
+            const std::complex<float> t = realSpectrum[j] + std::complex<float>(0, 1) * imagSpectrum[j];
+            // by Parseval, the product with the conjugate gives the bin
+            row[j] = std::conj(t) / (float)fftSize;
+            maxMagnitude = std::max(maxMagnitude, std::abs(row[j]));
+        }
+
+        for (uint32_t j = 0; j < numFftBins; ++j) {
+            if (std::abs(row[j]) >= kKernelThreshold * maxMagnitude) {
+                columns.push_back(j);
+                weights.push_back(row[j]);
+            }
+        }
+        rowStart.push_back((uint32_t)columns.size());
+    }
+}
+
+///
+void ConstantQOctave::configure(const Configuration &config)
+{
+    const ConstantQKernel &kernel = *_kernel;
+    const uint32_t numBins = kernel.numBins;
+    configureStepping(numBins, config);
+
+    // the kernel is windowed already
+    std::fill_n(getWindow(), config.windowSize, 1.0f);
+
+    _fftPlan = FFTPlanner::getInstance().forwardFFT(config.windowSize);
+    _cpx.resize(config.windowSize / 2 + 1);
+
+    float *frequencies = getFrequencies();
+    for (uint32_t i = 0; i < numBins; ++i)
+        frequencies[i] = (float)(kernel.frequencies[i] * config.sampleRate);
+}
+
+void ConstantQOctave::processNewBlock(float *input)
+{
+    const ConstantQKernel &kernel = *_kernel;
+
+    std::complex<float> *cpx = _cpx.data();
+    fftwf_execute_dft_r2c(_fftPlan, input, (fftwf_complex *)cpx);
+
+    const uint32_t numBins = kernel.numBins;
+    const uint32_t *rowStart = kernel.rowStart.data();
+    const uint32_t *columns = kernel.columns.data();
+    const std::complex<float> *weights = kernel.weights.data();
+
+    float *mag = getMagnitudes();
+    for (uint32_t i = 0; i < numBins; ++i) {
+        std::complex<float> sum = 0;
+        for (uint32_t j = rowStart[i], end = rowStart[i + 1]; j < end; ++j)
+            sum += weights[j] * cpx[columns[j]];
+        double linear = std::abs(sum);
+        double decibel = 20.0 * std::log10(std::max(kStftFloorMagnitude, linear));
+        mag[i] = decibel;
+    }
+}
+
+///
+void ConstantQ::configure(const Configuration &config)
+{
+    const double sampleRate = config.sampleRate;
+
+    // the finest resolution whose kernel fits in the FFT, or the coarsest
+    uint32_t binsPerOctave = 0;
+    uint32_t fftSize = 0;
+    double lowestFrequency = 0;
+    for (uint32_t choice : kBinsPerOctaveChoices) {
+        const double q = 1.0 / (std::exp2(1.0 / choice) - 1.0);
+        const double lowest = kTuningFrequency * std::exp2(
+            std::floor(choice * std::log2(0.5 * kTopFrequencyRatio * sampleRate / kTuningFrequency)) / choice);
+        uint32_t size = kStftMinSize;
+        while (size < kStftMaxSize && size < q * sampleRate / lowest)
+            size *= 2;
+        if (binsPerOctave != 0 && size > config.windowSize)
+            break;
+        binsPerOctave = choice;
+        fftSize = size;
+        lowestFrequency = lowest;
+    }
+
+    _kernel.configure(fftSize, binsPerOctave, lowestFrequency / sampleRate);
+
+    // enough octaves to reach the bottom of the audible range
+    uint32_t numOctaves = 1;
+    while (numOctaves < kCqMaxOctaves && lowestFrequency / (1u << (numOctaves - 1)) > kLowestFrequency)
+        ++numOctaves;
+
+    _numOctaves = numOctaves;
+    _octaves.reset(new Octave[numOctaves]);
+    _stepSize = config.stepSize;
+
+    configureBasic(numOctaves * binsPerOctave);
+
+    float *frequencies = getFrequencies();
+    for (uint32_t o = 0; o < numOctaves; ++o) {
+        Configuration octaveConfig = config;
+        octaveConfig.windowSize = fftSize;
+        octaveConfig.sampleRate = sampleRate / (1u << o);
+
+        Octave &octave = _octaves[o];
+        ConstantQOctave &analyzer = octave.analyzer;
+        analyzer.setKernel(&_kernel);
+        analyzer.configure(octaveConfig);
+        analyzer.setFrameInterval(_frameInterval >> o);
+        octave.previous.assign(binsPerOctave, 20.0 * std::log10(kStftFloorMagnitude));
+        octave.latest.assign(binsPerOctave, 20.0 * std::log10(kStftFloorMagnitude));
+
+        // output the lowest octave first
+        std::copy_n(analyzer.getFrequencies(), binsPerOctave, &frequencies[(numOctaves - 1 - o) * binsPerOctave]);
+    }
+
+    updateFramePeriods();
+}
+
+void ConstantQ::setAttackAndRelease(float attack, float release)
+{
+    for (uint32_t o = 0; o < _numOctaves; ++o)
+        _octaves[o].analyzer.setAttackAndRelease(attack, release);
+}
+
+void ConstantQ::setFrameInterval(uint32_t numFrames)
+{
+    _frameInterval = numFrames;
+    for (uint32_t o = 0; o < _numOctaves; ++o)
+        _octaves[o].analyzer.setFrameInterval(numFrames >> o);
+    updateFramePeriods();
+}
+
+void ConstantQ::updateFramePeriods()
+{
+    // in samples of the input, the octaves have frames on the multiples of
+    // their step which reach the interval, as in SteppingAnalyzer
+    const uint32_t stepSize = std::max(1u, _stepSize);
+    for (uint32_t o = 0; o < _numOctaves; ++o) {
+        const uint32_t stepsPerFrame = std::max(1u, (_frameInterval >> o) / stepSize);
+        _octaves[o].framePeriod = (stepsPerFrame * stepSize) << o;
+    }
+}
+
+void ConstantQ::clear()
+{
+    BasicAnalyzer::clear();
+
+    for (uint32_t o = 0; o < _numOctaves; ++o) {
+        Octave &octave = _octaves[o];
+        octave.analyzer.clear();
+        octave.downsampler.clear();
+        octave.hasRemainder = false;
+        std::copy_n(octave.analyzer.getMagnitudes(), _kernel.numBins, octave.latest.begin());
+        octave.previous = octave.latest;
+        octave.frameCounter = octave.analyzer.getFrameCounter();
+        octave.elapsed = 0;
+    }
+}
+
+void ConstantQ::process(const float *input, uint32_t numFrames)
+{
+    const uint32_t frameCounter = getOctavesFrameCounter();
+    const uint32_t totalFrames = numFrames;
+
+    while (numFrames > 0) {
+        const uint32_t currentFrames = std::min(numFrames, TempSamples);
+        processOctaves(input, currentFrames);
+        input += currentFrames;
+        numFrames -= currentFrames;
+    }
+
+    if (getOctavesFrameCounter() != frameCounter) {
+        processOutputBins(totalFrames);
+        advanceFrameCounter();
+    }
+    else {
+        for (uint32_t o = 0; o < _numOctaves; ++o)
+            _octaves[o].elapsed += totalFrames;
+    }
+}
+
+void ConstantQ::processOctaves(const float *input, uint32_t numFrames)
+{
+    const uint32_t numOctaves = _numOctaves;
+
+    for (uint32_t o = 0; o < numOctaves && numFrames > 0; ++o) {
+        Octave &octave = _octaves[o];
+        octave.analyzer.process(input, numFrames);
+
+        if (o + 1 == numOctaves)
+            break;
+
+        // decimate by 2 for the next octave, keeping any odd sample
+        float *pairs = octave.pairs;
+        uint32_t numPairedFrames = 0;
+        if (octave.hasRemainder)
+            pairs[numPairedFrames++] = octave.remainder;
+        std::copy_n(input, numFrames, &pairs[numPairedFrames]);
+        numPairedFrames += numFrames;
+
+        octave.hasRemainder = numPairedFrames & 1;
+        if (octave.hasRemainder)
+            octave.remainder = pairs[numPairedFrames - 1];
+
+        float *output = octave.output;
+        octave.downsampler.downsample(numPairedFrames / 2, pairs, &output);
+
+        input = output;
+        numFrames = numPairedFrames / 2;
+    }
+}
+
+void ConstantQ::processOutputBins(uint32_t numFrames)
+{
+    const uint32_t numOctaves = _numOctaves;
+    const uint32_t binsPerOctave = _kernel.numBins;
+    const uint32_t topPeriod = _octaves[0].framePeriod;
+
+    float *mags = getMagnitudes();
+    for (uint32_t o = 0; o < numOctaves; ++o) {
+        Octave &octave = _octaves[o];
+        const ConstantQOctave &analyzer = octave.analyzer;
+        float *output = &mags[(numOctaves - 1 - o) * binsPerOctave];
+
+        // a new frame of the octave, which the interpolation starts toward;
+        // it's taken at the end of the block, as the frames of the top one
+        const uint32_t counter = analyzer.getFrameCounter();
+        if (counter != octave.frameCounter) {
+            octave.frameCounter = counter;
+            octave.previous.swap(octave.latest);
+            std::copy_n(analyzer.getMagnitudes(), binsPerOctave, octave.latest.begin());
+            octave.elapsed = 0;
+        }
+        else
+            octave.elapsed += numFrames;
+
+        // the octaves with as many frames as the top one are output as is,
+        // the others go from their previous frame to the latest over their
+        // period, which delays them by that much
+        const float *latest = octave.latest.data();
+        if (octave.framePeriod <= topPeriod) {
+            std::copy_n(latest, binsPerOctave, output);
+            continue;
+        }
+
+        const float *previous = octave.previous.data();
+        const float mix = std::min(1.0f, (float)octave.elapsed / octave.framePeriod);
+        for (uint32_t i = 0; i < binsPerOctave; ++i)
+            output[i] = previous[i] + mix * (latest[i] - previous[i]);
+    }
+}
+
+uint32_t ConstantQ::getOctavesFrameCounter() const
+{
+    uint32_t frameCounter = 0;
+    for (uint32_t o = 0; o < _numOctaves; ++o)
+        frameCounter += _octaves[o].analyzer.getFrameCounter();
+    return frameCounter;
+}
+
+///
+constexpr uint32_t ConstantQ::TempSamples;
@@ -0,0 +1,90 @@
+#pragma once
+#include "SpectralAnalyzer.h"
+#include "Oversampling.h"
+#include "FFT_util.h"
+#include <vector>
+#include <memory>
+#include <complex>
+#include <cstdint>
+
+///
+// Spectral kernel of one octave of the constant-Q transform: a sparse matrix
+// in CSR form, one row per CQT bin, which applies to the bins of a FFT.
+// Frequencies are relative to the sample rate.
+struct ConstantQKernel {
+    void configure(uint32_t fftSize, uint32_t binsPerOctave, double lowestFrequency);
+
+    uint32_t fftSize = 0;
+    uint32_t numBins = 0;
+    std::vector<float> frequencies;
+    std::vector<uint32_t> rowStart;
+    std::vector<uint32_t> columns;
+    std::vector<std::complex<float>> weights;
+};
+
+///
+// One octave of the constant-Q transform, at the sample rate of its input.
+class ConstantQOctave final : public SteppingAnalyzer {
+public:
+    // the kernel must be set before configuring
+    void setKernel(const ConstantQKernel *kernel) { _kernel = kernel; }
+    void configure(const Configuration &config) override;
+
+    // analyzes an unwindowed block, before smoothing
+    void processNewBlock(float *input) override;
+
+private:
+    const ConstantQKernel *_kernel = nullptr;
+    fftwf_plan _fftPlan {};
+
+    // temporary
+    fftwf_complex_vector _cpx;
+};
+
+///
+// Constant-Q transform after Brown and Puckette, where bins are the products
+// of a FFT by a sparse kernel. The kernel covers only the upper octave; the
+// lower ones apply it again on the input decimated by successive factors 2,
+// with the same step, so that each octave costs half of the one above. The
+// octaves which have fewer frames than the top are interpolated in between.
+class ConstantQ final : public BasicAnalyzer {
+public:
+    void configure(const Configuration &config) override;
+    void setAttackAndRelease(float attack, float release) override;
+    void setFrameInterval(uint32_t numFrames) override;
+    void clear() override;
+    void process(const float *input, uint32_t numFrames) override;
+
+private:
+    void processOctaves(const float *input, uint32_t numFrames);
+    void processOutputBins(uint32_t numFrames);
+    void updateFramePeriods();
+    uint32_t getOctavesFrameCounter() const;
+
+private:
+    static constexpr uint32_t TempSamples = 1024u;
+
+    struct Octave {
+        ConstantQOctave analyzer;
+        // decimation for the next octave, with the odd sample of the last
+        // block waiting for its pair
+        Downsampler<1> downsampler;
+        float pairs[TempSamples + 1];
+        float output[TempSamples / 2 + 1];
+        float remainder = 0;
+        bool hasRemainder = false;
+        // the last two frames, and the input samples since the last, for the
+        // interpolation over the frame period
+        std::vector<float> previous;
+        std::vector<float> latest;
+        uint32_t frameCounter = 0;
+        uint32_t elapsed = 0;
+        uint32_t framePeriod = 0;
+    };
+
+    ConstantQKernel _kernel;
+    uint32_t _stepSize = 0;
+    uint32_t _frameInterval = 0;
+    uint32_t _numOctaves = 0;
+    std::unique_ptr<Octave[]> _octaves;
+};
@@ -0,0 +1,102 @@
+#include "CrossSpectrum.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+#include <cmath>
+
+// products of powers under this are treated as zero in ratios
+static constexpr float kNegligiblePower = 1e-30f;
+
+void CrossSpectrum::configure(uint32_t numBins, uint32_t windowSize, uint32_t stepSize, double sampleRate)
+{
+    _numBins = numBins;
+    _windowSize = windowSize;
+    _stepSize = stepSize;
+    _sampleRate = sampleRate;
+    _xx.resize(numBins);
+    _yy.resize(numBins);
+    _xyRe.resize(numBins);
+    _xyIm.resize(numBins);
+    _zeros.assign(2 * numBins, 0.0f);
+    clear();
+}
+
+void CrossSpectrum::setAveragingTime(double time)
+{
+    // the windows overlap, the independent ones are a window apart
+    time = std::max(time, kMinAverages * _windowSize / _sampleRate);
+    _coef = 1.0f - (float)std::exp(-(double)_stepSize / (time * _sampleRate));
+}
+
+void CrossSpectrum::clear()
+{
+    std::fill(_xx.begin(), _xx.end(), 0.0f);
+    std::fill(_yy.begin(), _yy.end(), 0.0f);
+    std::fill(_xyRe.begin(), _xyRe.end(), 0.0f);
+    std::fill(_xyIm.begin(), _xyIm.end(), 0.0f);
+}
+
+void CrossSpectrum::process(const std::complex<float> *x, const std::complex<float> *y)
+{
+    const uint32_t numBins = _numBins;
+    const float coef = _coef;
+    float *xx = _xx.data();
+    float *yy = _yy.data();
+    float *xyRe = _xyRe.data();
+    float *xyIm = _xyIm.data();
+
+    // a silent channel is a spectrum of zeros
+    const float *xf = x ? (const float *)x : _zeros.data();
+    const float *yf = y ? (const float *)y : _zeros.data();
+    for (uint32_t i = 0; i < numBins; ++i, xf += 2, yf += 2) {
+        const float xr = xf[0], xi = xf[1];
+        const float yr = yf[0], yi = yf[1];
+        xx[i] += coef * (xr * xr + xi * xi - xx[i]);
+        yy[i] += coef * (yr * yr + yi * yi - yy[i]);
+        xyRe[i] += coef * (xr * yr + xi * yi - xyRe[i]);
+        xyIm[i] += coef * (xr * yi - xi * yr - xyIm[i]);
+    }
+}
+
+void CrossSpectrum::computeCoherence(float *coherence) const
+{
+    const uint32_t numBins = _numBins;
+    const float *xx = _xx.data();
+    const float *yy = _yy.data();
+    const float *xyRe = _xyRe.data();
+    const float *xyIm = _xyIm.data();
+
+    for (uint32_t i = 0; i < numBins; ++i) {
+        const float cross = xyRe[i] * xyRe[i] + xyIm[i] * xyIm[i];
+        const float autos = xx[i] * yy[i];
+        coherence[i] = (autos > kNegligiblePower) ? std::min(1.0f, cross / autos) : 0.0f;
+    }
+}
+
+void CrossSpectrum::computePhase(float *phase) const
+{
+    const uint32_t numBins = _numBins;
+    const float *xyRe = _xyRe.data();
+    const float *xyIm = _xyIm.data();
+
+    const float radToDeg = (float)(180.0 / M_PI);
+    for (uint32_t i = 0; i < numBins; ++i)
+        phase[i] = radToDeg * std::atan2(xyIm[i], xyRe[i]);
+}
+
+void CrossSpectrum::computeTransferGain(float *gain) const
+{
+    const uint32_t numBins = _numBins;
+    const float *xx = _xx.data();
+    const float *xyRe = _xyRe.data();
+    const float *xyIm = _xyIm.data();
+
+    // |Sxy|^2 / Sxx^2 in power decibels, with an input too weak to tell
+    // counting as no transfer
+    const float floorDB = (float)kStftFloorMagnitudeInDB;
+    for (uint32_t i = 0; i < numBins; ++i) {
+        const float cross = xyRe[i] * xyRe[i] + xyIm[i] * xyIm[i];
+        const float input = xx[i] * xx[i];
+        gain[i] = (input > kNegligiblePower && cross > 0) ?
+            std::max(floorDB, 10.0f * std::log10(cross / input)) : floorDB;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <complex>
+#include <cstdint>
+
+///
+// Averaged auto- and cross-spectra of a pair of channels, from the complex
+// spectra of each analysis step, and the per-bin quantities derived from
+// them. The averages are exponential, over a given time, but no shorter than
+// kMinAverages windows, as the coherence of fewer is biased toward 1. The
+// spectra are stored as separate real and imaginary arrays, for the loops to
+// vectorize.
+class CrossSpectrum {
+public:
+    static constexpr uint32_t kMinAverages = 16;
+
+    void configure(uint32_t numBins, uint32_t windowSize, uint32_t stepSize, double sampleRate);
+    void setAveragingTime(double time);
+    void clear();
+
+    // accumulates the spectra of a step; a null spectrum is a silent one
+    void process(const std::complex<float> *x, const std::complex<float> *y);
+
+    // coherence of the channels, between 0 and 1
+    void computeCoherence(float *coherence) const;
+    // phase of the second channel relative to the first, in degrees; it is
+    // also the phase of the transfer function
+    void computePhase(float *phase) const;
+    // magnitude of the H1 transfer function from the first channel to the
+    // second, the cross-spectrum over the first auto-spectrum, in decibels
+    void computeTransferGain(float *gain) const;
+
+private:
+    uint32_t _numBins = 0;
+    uint32_t _windowSize = 0;
+    uint32_t _stepSize = 0;
+    double _sampleRate = 0;
+    float _coef = 0;
+
+    // auto-spectra
+    std::vector<float> _xx;
+    std::vector<float> _yy;
+    // cross-spectrum, conj(x)*y
+    std::vector<float> _xyRe;
+    std::vector<float> _xyIm;
+
+    // spectrum of a silent channel, interleaved
+    std::vector<float> _zeros;
+};
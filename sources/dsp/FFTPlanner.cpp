@@ -1,5 +1,16 @@
 #include "FFTPlanner.h"
 
+static unsigned getPlanFlags()
+{
+    unsigned planFlags = 0;
+#if defined(USE_IMPATIENT_FFT_PLANNING)
+    planFlags |= FFTW_ESTIMATE;
+#else
+    planFlags |= FFTW_MEASURE;
+#endif
+    return planFlags;
+}
+
 FFTPlanner& FFTPlanner::getInstance()
 {
     static FFTPlanner instance;
@@ -18,13 +29,30 @@ fftwf_plan FFTPlanner::forwardFFT(uint32_t windowSize)
     fftwf_real_vector real(windowSize);
     fftwf_complex_vector cpx(numBins);
 
-    int planFlags = 0;
-#if defined(USE_IMPATIENT_FFT_PLANNING)
-    planFlags |= FFTW_ESTIMATE;
-#else
-    planFlags |= FFTW_MEASURE;
-#endif
-    fftwf_plan plan = fftwf_plan_dft_r2c_1d(windowSize, real.data(), (fftwf_complex *)cpx.data(), planFlags);
+    fftwf_plan plan = fftwf_plan_dft_r2c_1d(windowSize, real.data(), (fftwf_complex *)cpx.data(), getPlanFlags());
     _forwardPlans[windowSize] = fftwf_plan_u(plan);
     return plan;
 }
+
+fftwf_plan FFTPlanner::forwardBatchFFT(uint32_t windowSize, uint32_t howMany)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    const std::pair<uint32_t, uint32_t> key(windowSize, howMany);
+    auto it = _forwardBatchPlans.find(key);
+    if (it != _forwardBatchPlans.end())
+        return it->second.get();
+
+    const uint32_t numBins = windowSize / 2 + 1;
+    fftwf_real_vector real(windowSize * howMany);
+    fftwf_complex_vector cpx(numBins * howMany);
+
+    const int size = (int)windowSize;
+    fftwf_plan plan = fftwf_plan_many_dft_r2c(
+        1, &size, (int)howMany,
+        real.data(), nullptr, 1, (int)windowSize,
+        (fftwf_complex *)cpx.data(), nullptr, 1, (int)numBins,
+        getPlanFlags());
+    _forwardBatchPlans[key] = fftwf_plan_u(plan);
+    return plan;
+}
@@ -2,6 +2,7 @@
 #include "FFT_util.h"
 #include <map>
 #include <mutex>
+#include <utility>
 
 class FFTPlanner {
 private:
@@ -10,8 +11,11 @@ private:
 public:
     static FFTPlanner& getInstance();
     fftwf_plan forwardFFT(uint32_t windowSize);
+    // transforms of `howMany` blocks, stored one after the other
+    fftwf_plan forwardBatchFFT(uint32_t windowSize, uint32_t howMany);
 
 private:
     std::mutex _mutex;
     std::map<uint32_t, fftwf_plan_u> _forwardPlans;
+    std::map<std::pair<uint32_t, uint32_t>, fftwf_plan_u> _forwardBatchPlans;
 };
@@ -0,0 +1,67 @@
+#include "MidSideSpectrum.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+#include <cmath>
+
+void MidSideSpectrum::configure(const Configuration &config)
+{
+    const uint32_t windowSize = config.windowSize;
+    const uint32_t numBins = windowSize / 2 + 1;
+    _numBins = numBins;
+
+    // the amplitude scale of the STFT, with the halves of M and S
+    _scale = 0.5f * (2.0f / windowSize);
+
+    _mid.resize(numBins);
+    _side.resize(numBins);
+    _midSmoother.configure(numBins, config.stepSize, config.attackTime, config.releaseTime, config.sampleRate);
+    _sideSmoother.configure(numBins, config.stepSize, config.attackTime, config.releaseTime, config.sampleRate);
+    _zeros.assign(2 * numBins, 0.0f);
+    clear();
+}
+
+void MidSideSpectrum::setAttackAndRelease(float attack, float release)
+{
+    _midSmoother.setAttackAndRelease(attack, release);
+    _sideSmoother.setAttackAndRelease(attack, release);
+}
+
+void MidSideSpectrum::clear()
+{
+    const float floorDB = (float)kStftFloorMagnitudeInDB;
+    std::fill(_mid.begin(), _mid.end(), floorDB);
+    std::fill(_side.begin(), _side.end(), floorDB);
+    _midSmoother.clear();
+    _sideSmoother.clear();
+}
+
+void MidSideSpectrum::process(const std::complex<float> *left, const std::complex<float> *right, uint32_t numSteps)
+{
+    const uint32_t numBins = _numBins;
+    float *mid = _mid.data();
+    float *side = _side.data();
+
+    if (!left && !right) {
+        const float floorDB = (float)kStftFloorMagnitudeInDB;
+        _midSmoother.processConstant(mid, floorDB, numSteps);
+        _sideSmoother.processConstant(side, floorDB, numSteps);
+        return;
+    }
+
+    const float *lf = left ? (const float *)left : _zeros.data();
+    const float *rf = right ? (const float *)right : _zeros.data();
+
+    // decibels from the squared magnitudes, saving the square roots
+    const float scale2 = _scale * _scale;
+    const float floorPower = (float)(kStftFloorMagnitude * kStftFloorMagnitude);
+    const float powerToDB = (float)(10.0 / M_LN10);
+    for (uint32_t i = 0; i < numBins; ++i, lf += 2, rf += 2) {
+        const float mr = lf[0] + rf[0], mi = lf[1] + rf[1];
+        const float sr = lf[0] - rf[0], si = lf[1] - rf[1];
+        mid[i] = powerToDB * std::log(std::max(floorPower, scale2 * (mr * mr + mi * mi)));
+        side[i] = powerToDB * std::log(std::max(floorPower, scale2 * (sr * sr + si * si)));
+    }
+
+    _midSmoother.process(mid, numSteps);
+    _sideSmoother.process(side, numSteps);
+}
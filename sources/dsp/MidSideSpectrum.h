@@ -0,0 +1,39 @@
+#pragma once
+#include "SpectralAnalyzer.h"
+#include "Smoother.h"
+#include <vector>
+#include <complex>
+#include <cstdint>
+
+///
+// Spectra of the mid and side signals of a pair of channels, formed from the
+// complex spectra of the STFT of each channel. The transform being linear,
+// M = (L+R)/2 and S = (L-R)/2 take sums of the spectra, and no transform of
+// their own. The magnitudes are on the scale of the STFT, and smoothed like
+// its own.
+class MidSideSpectrum {
+public:
+    void configure(const Configuration &config);
+    void setAttackAndRelease(float attack, float release);
+    void clear();
+
+    // analyzes the spectra of a frame, which accounts for a number of steps;
+    // a null spectrum is a silent one
+    void process(const std::complex<float> *left, const std::complex<float> *right, uint32_t numSteps);
+
+    uint32_t getNumBins() const { return _numBins; }
+    const float *getMidMagnitudes() const { return _mid.data(); }
+    const float *getSideMagnitudes() const { return _side.data(); }
+
+private:
+    uint32_t _numBins = 0;
+    float _scale = 0;
+
+    std::vector<float> _mid;
+    std::vector<float> _side;
+    Smoother _midSmoother;
+    Smoother _sideSmoother;
+
+    // spectrum of a silent channel, interleaved
+    std::vector<float> _zeros;
+};
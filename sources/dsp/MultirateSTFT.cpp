@@ -63,6 +63,13 @@ void MultirateSTFT<Rates>::setAttackAndRelease(float attack, float release)
         fStft[r].setAttackAndRelease(attack, release);
 }
 
+template <uint32_t Rates>
+void MultirateSTFT<Rates>::setFrameInterval(uint32_t numFrames)
+{
+    for (uint32_t r = 0; r < Rates; ++r)
+        fStft[r].setFrameInterval(numFrames >> r);
+}
+
 template <uint32_t Rates>
 void MultirateSTFT<Rates>::clear()
 {
@@ -81,6 +88,8 @@ void MultirateSTFT<Rates>::clear()
 template <uint32_t Rates>
 void MultirateSTFT<Rates>::process(const float *input, uint32_t numFrames)
 {
+    const uint32_t frameCounter = getMultirateFrameCounter();
+
     uint32_t numRemainder = fNumRemainder;
     float *remainder = fRemainder;
 
@@ -95,8 +104,10 @@ void MultirateSTFT<Rates>::process(const float *input, uint32_t numFrames)
         input += numAvail;
         numFrames -= numAvail;
 
-        if (numRemainder < Factor)
+        if (numRemainder < Factor) {
+            fNumRemainder = numRemainder;
             return;
+        }
         numRemainder = 0;
 
         processMultirate(remainder, Factor);
@@ -119,7 +130,10 @@ void MultirateSTFT<Rates>::process(const float *input, uint32_t numFrames)
         numFrames -= currentFrames;
     }
 
-    processOutputBins();
+    if (getMultirateFrameCounter() != frameCounter) {
+        processOutputBins();
+        advanceFrameCounter();
+    }
 
     fNumRemainder = numRemainder;
 }
@@ -127,7 +141,7 @@ void MultirateSTFT<Rates>::process(const float *input, uint32_t numFrames)
 template <uint32_t Rates>
 void MultirateSTFT<Rates>::processMultirate(const float *input, uint32_t numFrames)
 {
-    assert(numFrames < TempSamples);
+    assert(numFrames <= TempSamples);
     assert(numFrames % Factor == 0);
 
     float *downsampledInputs[Rates - 1];
@@ -157,6 +171,15 @@ void MultirateSTFT<Rates>::processOutputBins()
         mags[b] = multirateMags[binMappings[b].rate][binMappings[b].bin];
 }
 
+template <uint32_t Rates>
+uint32_t MultirateSTFT<Rates>::getMultirateFrameCounter() const
+{
+    uint32_t frameCounter = 0;
+    for (uint32_t r = 0; r < Rates; ++r)
+        frameCounter += fStft[r].getFrameCounter();
+    return frameCounter;
+}
+
 ///
 template <uint32_t Rates> constexpr uint32_t MultirateSTFT<Rates>::Log2Factor;
 template <uint32_t Rates> constexpr uint32_t MultirateSTFT<Rates>::Factor;
@@ -8,12 +8,14 @@ class MultirateSTFT final : public BasicAnalyzer {
 public:
     void configure(const Configuration &config) override;
     void setAttackAndRelease(float attack, float release) override;
+    void setFrameInterval(uint32_t numFrames) override;
     void clear() override;
     void process(const float *input, uint32_t numFrames) override;
 
 private:
     void processMultirate(const float *input, uint32_t numFrames);
     void processOutputBins();
+    uint32_t getMultirateFrameCounter() const;
 
 private:
     static constexpr uint32_t Log2Factor = Rates - 1;
@@ -0,0 +1,93 @@
+#include "Multitaper.h"
+#include "FFTPlanner.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+#include <cmath>
+
+// the number of tapers, which widens the bandwidth to about K+1 bins
+static constexpr uint32_t kMultitaperCount = 5;
+
+void Multitaper::configure(const Configuration &config)
+{
+    const uint32_t windowSize = config.windowSize;
+    const uint32_t numBins = windowSize / 2 + 1;
+    const uint32_t numTapers = kMultitaperCount;
+    configureStepping(numBins, config);
+
+    // the tapers are applied here, the block comes in unwindowed
+    std::fill_n(getWindow(), windowSize, 1.0f);
+
+    const double sampleRate = config.sampleRate;
+    _fftPlan = FFTPlanner::getInstance().forwardBatchFFT(windowSize, numTapers);
+
+    // sine tapers, of unit energy; the response of each to a sinusoid at
+    // the center of a bin is its sum
+    _tapers.resize(numTapers * windowSize);
+    double sumOfSquaredResponses = 0;
+    const double norm = std::sqrt(2.0 / (windowSize + 1));
+    for (uint32_t k = 0; k < numTapers; ++k) {
+        float *taper = &_tapers[k * windowSize];
+        double response = 0;
+        for (uint32_t i = 0; i < windowSize; ++i) {
+            taper[i] = (float)(norm * std::sin(M_PI * (k + 1) * (i + 1) / (windowSize + 1)));
+            response += taper[i];
+        }
+        sumOfSquaredResponses += response * response;
+    }
+
+    // scaled like the STFT, for a sinusoid to read its amplitude halved
+    _powerScale = 1.0 / sumOfSquaredResponses;
+
+    _tapered.resize(numTapers * windowSize);
+    _cpx.resize(numTapers * numBins);
+    _powers.resize(numBins);
+
+    float *frequencies = getFrequencies();
+    for (uint32_t i = 0; i < numBins; ++i)
+        frequencies[i] = (float)(i * sampleRate / windowSize);
+}
+
+void Multitaper::processNewBlock(float *input)
+{
+    const uint32_t windowSize = getWindowSize();
+    const uint32_t numBins = windowSize / 2 + 1;
+    const uint32_t numTapers = kMultitaperCount;
+
+    const float *tapers = _tapers.data();
+    float *tapered = _tapered.data();
+    for (uint32_t k = 0; k < numTapers; ++k) {
+        const float *taper = &tapers[k * windowSize];
+        float *block = &tapered[k * windowSize];
+        for (uint32_t i = 0; i < windowSize; ++i)
+            block[i] = input[i] * taper[i];
+    }
+
+    fftwf_plan plan = _fftPlan;
+    std::complex<float> *cpx = _cpx.data();
+    fftwf_execute_dft_r2c(plan, tapered, (fftwf_complex *)cpx);
+
+    const uint32_t *binRange = getBinRange();
+    uint32_t start = binRange[0];
+    uint32_t end = std::min(binRange[1], numBins);
+
+    // sum of the powers, over contiguous arrays for vectorization
+    float *powers = _powers.data();
+    std::fill_n(&powers[start], end - start, 0.0f);
+    for (uint32_t k = 0; k < numTapers; ++k) {
+        const float *spectrum = (const float *)&cpx[k * numBins];
+        for (uint32_t i = start; i < end; ++i) {
+            const float re = spectrum[2 * i];
+            const float im = spectrum[2 * i + 1];
+            powers[i] += re * re + im * im;
+        }
+    }
+
+    const double powerScale = _powerScale;
+    const double floorPower = kStftFloorMagnitude * kStftFloorMagnitude;
+    float *mag = getMagnitudes();
+    for (uint32_t i = start; i < end; ++i) {
+        double power = powers[i] * powerScale;
+        double decibel = 10.0 * std::log10(std::max(floorPower, power));
+        mag[i] = decibel;
+    }
+}
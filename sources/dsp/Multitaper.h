@@ -0,0 +1,31 @@
+#pragma once
+#include "SpectralAnalyzer.h"
+#include "FFT_util.h"
+#include <vector>
+#include <cstdint>
+
+///
+// Multitaper estimator, after Riedel and Sidorenko: the power spectrum is the
+// average of the spectra under K orthogonal sine tapers, whose estimates are
+// nearly independent. The variance on noise is about K times lower than under
+// a single window of the same size, at the same latency; the K transforms run
+// as a single batched plan.
+class Multitaper final : public SteppingAnalyzer {
+public:
+    void configure(const Configuration &config) override;
+
+    // analyzes an unwindowed block, before smoothing
+    void processNewBlock(float *input) override;
+
+private:
+    fftwf_plan _fftPlan {};
+
+    // the tapers one after the other, and the scale of the averaged power
+    fftwf_real_vector _tapers;
+    double _powerScale = 0;
+
+    // temporary
+    fftwf_real_vector _tapered;
+    fftwf_complex_vector _cpx;
+    std::vector<float> _powers;
+};
@@ -0,0 +1,107 @@
+#include "ReassignedSTFT.h"
+#include "FFTPlanner.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+#include <cmath>
+
+// the factor of the output grid over the bins of the FFT, limited so the
+// grid is no finer than the one of the largest STFT
+static constexpr uint32_t kReassignOversampling = 8;
+
+// the sum of the powers of the main lobe of a Hann window, relative to its
+// peak, which all goes into the same cell for a sinusoid
+static constexpr double kHannEnbw = 1.5;
+
+// components whose energy is centered further than this fraction of the
+// window away from its center keep their frequency
+static constexpr double kMaxTimeOffset = 0.25;
+
+void ReassignedSTFT::configure(const Configuration &config)
+{
+    const uint32_t windowSize = config.windowSize;
+    const uint32_t oversampling = _oversampling = std::max(1u, std::min(kReassignOversampling, kStftMaxSize / windowSize));
+    const uint32_t numBins = oversampling * windowSize / 2 + 1;
+    configureStepping(numBins, config);
+
+    // the windows are applied here, the block comes in unwindowed
+    std::fill_n(getWindow(), windowSize, 1.0f);
+
+    const double sampleRate = config.sampleRate;
+    _fftPlan = FFTPlanner::getInstance().forwardFFT(windowSize);
+
+    for (fftwf_real_vector &window : _windows)
+        window.resize(windowSize);
+    const double omega = 2.0 * M_PI / (windowSize - 1);
+    const double center = 0.5 * (windowSize - 1);
+    for (uint32_t i = 0; i < windowSize; ++i) {
+        const double hann = 0.5 * (1.0 - std::cos(omega * i));
+        _windows[0][i] = (float)hann;
+        _windows[1][i] = (float)(0.5 * omega * std::sin(omega * i));
+        _windows[2][i] = (float)((i - center) * hann);
+    }
+
+    _windowed.resize(windowSize);
+    for (fftwf_complex_vector &cpx : _cpx)
+        cpx.resize(windowSize / 2 + 1);
+    _powers.resize(numBins);
+
+    float *frequencies = getFrequencies();
+    for (uint32_t i = 0; i < numBins; ++i)
+        frequencies[i] = (float)(i * sampleRate / (oversampling * windowSize));
+}
+
+void ReassignedSTFT::processNewBlock(float *input)
+{
+    const uint32_t windowSize = getWindowSize();
+    const uint32_t numFftBins = windowSize / 2 + 1;
+    const uint32_t oversampling = _oversampling;
+    const uint32_t numBins = getNumBins();
+
+    fftwf_plan plan = _fftPlan;
+    float *windowed = _windowed.data();
+    for (uint32_t w = 0; w < 3; ++w) {
+        const float *window = _windows[w].data();
+        for (uint32_t i = 0; i < windowSize; ++i)
+            windowed[i] = input[i] * window[i];
+        fftwf_execute_dft_r2c(plan, windowed, (fftwf_complex *)_cpx[w].data());
+    }
+
+    const std::complex<float> *cpx = _cpx[0].data();
+    const std::complex<float> *cpxDerivative = _cpx[1].data();
+    const std::complex<float> *cpxRamp = _cpx[2].data();
+
+    float *powers = _powers.data();
+    std::fill_n(powers, numBins, 0.0f);
+
+    const double scale = 2.0 / windowSize;
+    const double floorPower = kStftFloorMagnitude * kStftFloorMagnitude;
+    const double binsPerRadian = windowSize / (2.0 * M_PI);
+    const double maxTimeOffset = kMaxTimeOffset * windowSize;
+
+    for (uint32_t k = 0; k < numFftBins; ++k) {
+        const std::complex<double> x = cpx[k];
+        const double norm = std::norm(x);
+        const double power = norm * (scale * scale);
+        if (power < floorPower)
+            continue;
+
+        // the instantaneous frequency, and the center of the energy in time
+        double position = k;
+        const double timeOffset = (std::complex<double>(cpxRamp[k]) * std::conj(x)).real() / norm;
+        if (std::fabs(timeOffset) < maxTimeOffset) {
+            const double frequencyOffset = (std::complex<double>(cpxDerivative[k]) * std::conj(x)).imag() / norm;
+            position -= frequencyOffset * binsPerRadian;
+        }
+
+        const long cell = std::lround(position * oversampling);
+        if (cell >= 0 && cell < (long)numBins)
+            powers[cell] += (float)power;
+    }
+
+    float *mag = getMagnitudes();
+    for (uint32_t i = 0; i < numBins; ++i) {
+        double power = powers[i] * (1.0 / kHannEnbw);
+        double decibel = 10.0 * std::log10(std::max(floorPower, power));
+        mag[i] = decibel;
+    }
+}
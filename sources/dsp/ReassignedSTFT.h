@@ -0,0 +1,33 @@
+#pragma once
+#include "SpectralAnalyzer.h"
+#include "FFT_util.h"
+#include <vector>
+#include <cstdint>
+
+///
+// STFT with reassignment in frequency: every bin of the Hann spectrum moves
+// its energy to the instantaneous frequency of its component, estimated with
+// the spectrum under the derivative of the window. The energy accumulates on
+// a grid finer than the FFT, so that a sinusoid gets a sharp peak at the
+// latency of the small window. The spectrum under the time-ramped window
+// locates the energy in time; components far off the center of the window,
+// such as transients, are not reassigned.
+class ReassignedSTFT final : public SteppingAnalyzer {
+public:
+    void configure(const Configuration &config) override;
+
+    // analyzes an unwindowed block, before smoothing
+    void processNewBlock(float *input) override;
+
+private:
+    fftwf_plan _fftPlan {};
+    uint32_t _oversampling = 0;
+
+    // the Hann window, its derivative, and the Hann window times the time
+    fftwf_real_vector _windows[3];
+
+    // temporary
+    fftwf_real_vector _windowed;
+    fftwf_complex_vector _cpx[3];
+    std::vector<float> _powers;
+};
@@ -25,18 +25,30 @@ void STFT::processNewBlock(float *input)
     const uint32_t windowSize = getWindowSize();
     const uint32_t numBins = windowSize / 2 + 1;
 
-    fftwf_plan plan = _fftPlan;
-    std::complex<float> *cpx = _cpx.data();
-    fftwf_execute_dft_r2c(plan, input, (fftwf_complex *)cpx);
+    processNewSpectrum(input);
+    const std::complex<float> *cpx = _cpx.data();
 
     const uint32_t *binRange = getBinRange();
     uint32_t start = binRange[0];
     uint32_t end = std::min(binRange[1], numBins);
 
+    // decibels from the squared magnitudes, in single precision, which
+    // vectorizes along the bins
+    const float scale = 2.0f / windowSize;
+    const float scale2 = scale * scale;
+    const float floorPower = (float)(kStftFloorMagnitude * kStftFloorMagnitude);
+    const float powerToDB = (float)(10.0 / M_LN10);
+
     float *mag = getMagnitudes();
-    for (uint32_t i = start; i < end; ++i) {
-        double linear = std::abs(cpx[i]) * (2.0f / windowSize);
-        double decibel = 20.0 * std::log10(std::max(kStftFloorMagnitude, linear));
-        mag[i] = decibel;
+    const float *cf = (const float *)&cpx[start];
+    for (uint32_t i = start; i < end; ++i, cf += 2) {
+        const float re = cf[0], im = cf[1];
+        mag[i] = powerToDB * std::log(std::max(floorPower, scale2 * (re * re + im * im)));
     }
 }
+
+void STFT::processNewSpectrum(float *input)
+{
+    fftwf_execute_dft_r2c(_fftPlan, input, (fftwf_complex *)_cpx.data());
+    advanceSpectrumCounter();
+}
@@ -8,13 +8,16 @@ class STFT final : public SteppingAnalyzer {
 public:
     void configure(const Configuration &config) override;
 
-private:
+    // analyzes a windowed block, before smoothing
     void processNewBlock(float *input) override;
+    void processNewSpectrum(float *input) override;
+
+    const std::complex<float> *getSpectrum() const override { return _cpx.data(); }
 
 private:
     fftwf_plan _fftPlan {};
     double _sampleRate {};
 
-    // temporary
+    // spectrum of the latest block
     fftwf_complex_vector _cpx;
 };
@@ -0,0 +1,176 @@
+#include "SlidingDFT.h"
+#include "AnalyzerDefs.h"
+#include "util/trace_events.h"
+#include <algorithm>
+#include <cmath>
+
+// the bins are on the notes tuned to this frequency
+static constexpr double kTuningFrequency = 440.0;
+
+static constexpr double kLowestFrequency = 20.0;
+
+// the highest bin stays under this fraction of the sample rate
+static constexpr double kHighestFrequencyRatio = 0.45;
+
+void SlidingDFT::configure(const Configuration &config)
+{
+    const double sampleRate = config.sampleRate;
+    const uint32_t windowSize = _windowSize = config.windowSize;
+
+    // windows long enough for neighboring notes to be a DFT bin apart
+    const double q = 1.0 / (std::exp2(1.0 / 12.0) - 1.0);
+
+    const int firstNote = (int)std::ceil(12.0 * std::log2(kLowestFrequency / kTuningFrequency));
+    const int lastNote = (int)std::floor(12.0 * std::log2(kHighestFrequencyRatio * sampleRate / kTuningFrequency));
+    const uint32_t numBins = (uint32_t)std::max(0, lastNote - firstNote + 1);
+
+    configureBasic(numBins);
+    _bins.resize(numBins);
+
+    float *frequencies = getFrequencies();
+    for (uint32_t k = 0; k < numBins; ++k) {
+        const double frequency = kTuningFrequency * std::exp2((firstNote + (int)k) / 12.0);
+        frequencies[k] = (float)frequency;
+
+        Bin &bin = _bins[k];
+        const uint32_t length = std::min(windowSize, (uint32_t)std::ceil(q * sampleRate / frequency));
+        const double omega = 2.0 * M_PI * frequency / sampleRate;
+        const double delta = 2.0 * M_PI / length;
+        bin.length = length;
+        bin.leaving = std::polar(1.0, omega * length);
+        bin.rotation[0] = std::polar(1.0, omega);
+        bin.rotation[1] = std::polar(1.0, omega + delta);
+        bin.rotation[2] = std::polar(1.0, omega - delta);
+    }
+
+    _history.resize(windowSize + std::max(windowSize, TempSamples));
+    _historyIndex = windowSize;
+    _stepSize = config.stepSize;
+
+    _smoother.configure(numBins, config.stepSize, config.attackTime, config.releaseTime, sampleRate);
+}
+
+void SlidingDFT::setAttackAndRelease(float attack, float release)
+{
+    _smoother.setAttackAndRelease(attack, release);
+}
+
+void SlidingDFT::setFrameInterval(uint32_t numFrames)
+{
+    _frameInterval = numFrames;
+}
+
+void SlidingDFT::clear()
+{
+    BasicAnalyzer::clear();
+
+    for (Bin &bin : _bins)
+        std::fill_n(bin.sum, 3, 0.0);
+
+    std::fill(_history.begin(), _history.end(), 0.0f);
+    _historyIndex = _windowSize;
+
+    _stepCounter = 0;
+    _pendingSteps = 0;
+
+    _smoother.clear();
+}
+
+void SlidingDFT::process(const float *input, uint32_t numFrames)
+{
+    const uint32_t windowSize = _windowSize;
+    const uint32_t stepSize = _stepSize;
+    const uint32_t stepsPerFrame = std::max(1u, _frameInterval / stepSize);
+
+    float *history = _history.data();
+    const uint32_t historyCapacity = (uint32_t)_history.size();
+
+    while (numFrames > 0) {
+        // blocks end at the steps, and fit in the history
+        uint32_t currentFrames = std::min(numFrames, stepSize - _stepCounter);
+        currentFrames = std::min(currentFrames, TempSamples);
+
+        if (_historyIndex + currentFrames > historyCapacity) {
+            std::copy_n(&history[_historyIndex - windowSize], windowSize, history);
+            _historyIndex = windowSize;
+        }
+
+        std::copy_n(input, currentFrames, &history[_historyIndex]);
+        {
+            TRACE_SCOPE("processBins");
+            processBins(currentFrames);
+        }
+        _historyIndex += currentFrames;
+
+        input += currentFrames;
+        numFrames -= currentFrames;
+
+        _stepCounter += currentFrames;
+        if (_stepCounter == stepSize) {
+            _stepCounter = 0;
+
+            // compute only the last step of each frame interval, and let the
+            // smoother hold its result over the steps which were dropped
+            if (++_pendingSteps < stepsPerFrame)
+                continue;
+
+            processOutputBins();
+
+            {
+                TRACE_SCOPE("smoother");
+                _smoother.process(getMagnitudes(), _pendingSteps);
+                _pendingSteps = 0;
+            }
+
+            advanceFrameCounter();
+        }
+    }
+}
+
+void SlidingDFT::processBins(uint32_t numFrames)
+{
+    const float *current = &_history[_historyIndex];
+
+    for (Bin &bin : _bins) {
+        const float *leaving = current - bin.length;
+        const std::complex<double> rotation0 = bin.rotation[0];
+        const std::complex<double> rotation1 = bin.rotation[1];
+        const std::complex<double> rotation2 = bin.rotation[2];
+        const std::complex<double> leavingRotation = bin.leaving;
+        std::complex<double> sum0 = bin.sum[0];
+        std::complex<double> sum1 = bin.sum[1];
+        std::complex<double> sum2 = bin.sum[2];
+
+        // the sample which leaves the window has the same rotation at the
+        // frequency and at its neighbors, which are a cycle away over it
+        for (uint32_t i = 0; i < numFrames; ++i) {
+            const std::complex<double> difference = (double)current[i] - leavingRotation * (double)leaving[i];
+            sum0 = rotation0 * sum0 + difference;
+            sum1 = rotation1 * sum1 + difference;
+            sum2 = rotation2 * sum2 + difference;
+        }
+
+        bin.sum[0] = sum0;
+        bin.sum[1] = sum1;
+        bin.sum[2] = sum2;
+    }
+}
+
+void SlidingDFT::processOutputBins()
+{
+    const uint32_t numBins = getNumBins();
+    const Bin *bins = _bins.data();
+
+    float *mag = getMagnitudes();
+    for (uint32_t k = 0; k < numBins; ++k) {
+        const Bin &bin = bins[k];
+        // the Hann window applied in the frequency domain
+        const std::complex<double> windowed = 0.5 * bin.sum[0] - 0.25 * (bin.sum[1] + bin.sum[2]);
+        double linear = std::abs(windowed) * (2.0 / bin.length);
+        double decibel = 20.0 * std::log10(std::max(kStftFloorMagnitude, linear));
+        mag[k] = decibel;
+    }
+}
+
+///
+constexpr uint32_t SlidingDFT::TempSamples;
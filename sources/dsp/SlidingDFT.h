@@ -0,0 +1,56 @@
+#pragma once
+#include "SpectralAnalyzer.h"
+#include "Smoother.h"
+#include <vector>
+#include <complex>
+#include <cstdint>
+
+///
+// Sliding discrete Fourier transform, updated on every sample for a set of
+// bins on the equal-tempered notes. Each bin is a Hann-windowed DFT over a
+// window of a semitone of resolution, or the analysis size if shorter, made
+// from the sliding DFTs at its frequency and the two neighbors of the window.
+// The cost is a fixed amount of work per bin and per sample.
+class SlidingDFT final : public BasicAnalyzer {
+public:
+    void configure(const Configuration &config) override;
+    void setAttackAndRelease(float attack, float release) override;
+    void setFrameInterval(uint32_t numFrames) override;
+    void clear() override;
+    void process(const float *input, uint32_t numFrames) override;
+
+private:
+    void processBins(uint32_t numFrames);
+    void processOutputBins();
+
+private:
+    static constexpr uint32_t TempSamples = 1024u;
+
+    struct Bin {
+        // length of the window, and rotation of a sample leaving it
+        uint32_t length = 0;
+        std::complex<double> leaving;
+        // rotations per sample and sums, at the frequency and at the
+        // neighbors whose combination applies the Hann window
+        std::complex<double> rotation[3];
+        std::complex<double> sum[3];
+    };
+
+    std::vector<Bin> _bins;
+
+    // input history, the last `_windowSize` samples before `_historyIndex`
+    std::vector<float> _history;
+    uint32_t _historyIndex = 0;
+    uint32_t _windowSize = 0;
+
+    // analysis step
+    uint32_t _stepCounter = 0;
+    uint32_t _stepSize = 0;
+
+    // decimation: steps to account for at the next computed one
+    uint32_t _frameInterval = 0;
+    uint32_t _pendingSteps = 0;
+
+    // step-by-step smoother
+    Smoother _smoother;
+};
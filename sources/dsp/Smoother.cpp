@@ -0,0 +1,80 @@
+#include "Smoother.h"
+#include <algorithm>
+#include <cmath>
+
+void Smoother::configure(uint32_t numBins, uint32_t stepSize, double attackTime, double releaseTime, double sampleRate)
+{
+    _state.resize(numBins);
+    _stepSize = stepSize;
+    _sampleRate = sampleRate;
+    setAttackAndRelease(attackTime, releaseTime);
+}
+
+void Smoother::configureBinRange(uint32_t start, uint32_t end)
+{
+    _binRange[0] = start;
+    _binRange[1] = end;
+}
+
+void Smoother::setAttackAndRelease(float attack, float release)
+{
+    // one-pole lag, running once per step
+    const double stepTime = _stepSize / _sampleRate;
+    _attackCoef = (float)std::exp(-stepTime / attack);
+    _releaseCoef = (float)std::exp(-stepTime / release);
+}
+
+void Smoother::clear()
+{
+    std::fill(_state.begin(), _state.end(), 0.0f);
+}
+
+void Smoother::process(float *stepData)
+{
+    processWithCoefficients(stepData, _attackCoef, _releaseCoef);
+}
+
+void Smoother::process(float *stepData, uint32_t numSteps)
+{
+    if (numSteps == 1) {
+        process(stepData);
+        return;
+    }
+
+    // equivalent to running `numSteps` frames which all have the same data;
+    // the lag converges toward a constant input monotonically, so the same
+    // coefficient applies at every step
+    const float attackPow = std::pow(_attackCoef, (float)numSteps);
+    const float releasePow = std::pow(_releaseCoef, (float)numSteps);
+    processWithCoefficients(stepData, attackPow, releasePow);
+}
+
+void Smoother::processConstant(float *stepData, float value, uint32_t numSteps)
+{
+    uint32_t numBins = (uint32_t)_state.size();
+
+    uint32_t start = _binRange[0];
+    uint32_t end = std::min(_binRange[1], numBins);
+
+    if (start < end)
+        std::fill(stepData + start, stepData + end, value);
+    process(stepData, numSteps);
+}
+
+void Smoother::processWithCoefficients(float *stepData, float attackCoef, float releaseCoef)
+{
+    float *state = _state.data();
+    uint32_t numBins = (uint32_t)_state.size();
+
+    uint32_t start = _binRange[0];
+    uint32_t end = std::min(_binRange[1], numBins);
+
+    for (uint32_t i = start; i < end; ++i) {
+        const float x = stepData[i];
+        const float prev = state[i];
+        const float coef = (prev > x) ? releaseCoef : attackCoef;
+        const float y = prev * coef + x * (1.0f - coef);
+        state[i] = y;
+        stepData[i] = y;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+///
+// Attack and release smoothing of successive analysis frames, bin by bin.
+// All bins share the coefficients, and their states are contiguous, so the
+// loops vectorize along the bins.
+class Smoother {
+public:
+    void configure(uint32_t numBins, uint32_t stepSize, double attackTime, double releaseTime, double sampleRate);
+    void configureBinRange(uint32_t start, uint32_t end);
+    void setAttackAndRelease(float attack, float release);
+    void clear();
+    void process(float *stepData);
+    void process(float *stepData, uint32_t numSteps);
+    void processConstant(float *stepData, float value, uint32_t numSteps);
+
+private:
+    void processWithCoefficients(float *stepData, float attackCoef, float releaseCoef);
+
+private:
+    std::vector<float> _state;
+    float _attackCoef = 0;
+    float _releaseCoef = 0;
+    uint32_t _stepSize = 0;
+    double _sampleRate = 0;
+    uint32_t _binRange[2] = { 0u, ~0u };
+};
@@ -1,4 +1,5 @@
 #include "SpectralAnalyzer.h"
+#include "util/trace_events.h"
 #include <algorithm>
 #include <cmath>
 
@@ -48,14 +49,34 @@ void SteppingAnalyzer::setAttackAndRelease(float attack, float release)
     _smoother.setAttackAndRelease(attack, release);
 }
 
+void SteppingAnalyzer::setFrameInterval(uint32_t numFrames)
+{
+    _frameInterval = numFrames;
+}
+
+void SteppingAnalyzer::setSpectrumEveryStep(bool enable)
+{
+    _spectrumEveryStep = enable;
+}
+
+void SteppingAnalyzer::setSpectrumOnly(bool enable)
+{
+    _spectrumOnly = enable;
+}
+
 void SteppingAnalyzer::clear()
 {
     BasicAnalyzer::clear();
 
     _stepCounter = 0;
+    _pendingSteps = 0;
+    _framePhase = 0;
     _ringIndex = 0;
     std::fill(_ring.begin(), _ring.end(), 0.0f);
 
+    _silentRun = 0;
+    _silenceSettled = false;
+
     _smoother.clear();
 }
 
@@ -67,71 +88,119 @@ void SteppingAnalyzer::process(const float *input, uint32_t numFrames)
     uint32_t stepCounter = _stepCounter;
     const uint32_t stepSize = _stepSize;
 
+    // compute only the last step of each frame interval, and let the smoother
+    // hold its result over the steps which were dropped; the intervals are
+    // counted from the clear, so that channels have their frames together
+    uint32_t pendingSteps = _pendingSteps;
+    uint32_t framePhase = _framePhase;
+    const uint32_t stepsPerFrame = std::max(1u, _frameInterval / stepSize);
+
     float *ring = _ring.data();
     uint32_t ringIndex = _ringIndex;
 
+    uint32_t silentRun = _silentRun;
+    uint32_t silentSteps = 0;
+    bool silentFrame = false; // whether one of the silent steps is a frame
+
     for (uint32_t i = 0; i < numFrames; ++i) {
-        ring[ringIndex] = ring[ringIndex + windowSize] = input[i];
+        const float sample = input[i];
+        ring[ringIndex] = ring[ringIndex + windowSize] = sample;
         ringIndex = (ringIndex + 1 != windowSize) ? (ringIndex + 1) : 0;
+        silentRun = (std::fabs(sample) < (float)kStftSilenceThreshold) ? std::min(silentRun + 1, windowSize) : 0;
         if (++stepCounter == stepSize) {
             stepCounter = 0;
+            ++pendingSteps;
+
+            const bool isFrame = ++framePhase >= stepsPerFrame;
+            if (isFrame)
+                framePhase = 0;
+
+            // the spectrum of a silent window is the floor, skip computing it
+            // and account for these steps all at once
+            if (silentRun == windowSize && _silenceSkipping) {
+                silentSteps += pendingSteps;
+                silentFrame = silentFrame || isFrame;
+                pendingSteps = 0;
+                continue;
+            }
+
+            // the silence ends
+            if (silentSteps > 0) {
+                processSilentSteps(silentSteps, silentFrame);
+                silentSteps = 0;
+                silentFrame = false;
+            }
+            _silenceSettled = false;
+
+            if (!isFrame && !_spectrumEveryStep)
+                continue;
 
             float* windowedBlock = _input.data();
             for (uint32_t i = 0; i < windowSize; ++i)
                 windowedBlock[i] = ring[ringIndex + i] * window[i];
 
-            processNewBlock(windowedBlock);
-
-            _smoother.process(getMagnitudes());
+            if (!isFrame || _spectrumOnly) {
+                TRACE_SCOPE("processNewSpectrum");
+                processNewSpectrum(windowedBlock);
+                if (isFrame) {
+                    pendingSteps = 0;
+                    advanceFrameCounter();
+                }
+                continue;
+            }
+
+            {
+                TRACE_SCOPE("processNewBlock");
+                processNewBlock(windowedBlock);
+            }
+
+            {
+                TRACE_SCOPE("smoother");
+                _smoother.process(getMagnitudes(), pendingSteps);
+                pendingSteps = 0;
+            }
+
+            advanceFrameCounter();
         }
     }
 
+    if (silentSteps > 0)
+        processSilentSteps(silentSteps, silentFrame);
+
     _stepCounter = stepCounter;
+    _pendingSteps = pendingSteps;
+    _framePhase = framePhase;
     _ringIndex = ringIndex;
+    _silentRun = silentRun;
 }
 
-void SteppingAnalyzer::Smoother::configure(uint32_t numBins, uint32_t stepSize, double attackTime, double releaseTime, double sampleRate)
-{
-    _ar.resize(numBins);
-    _stepSize = stepSize;
-    ARFollower *ar = _ar.data();
-    ar[0].init(sampleRate);
-    setAttackAndRelease(attackTime, releaseTime);
-}
-
-void SteppingAnalyzer::Smoother::configureBinRange(uint32_t start, uint32_t end)
-{
-    _binRange[0] = start;
-    _binRange[1] = end;
-}
-
-void SteppingAnalyzer::Smoother::setAttackAndRelease(float attack, float release)
+void SteppingAnalyzer::processSilentSteps(uint32_t numSteps, bool hasFrame)
 {
-    ARFollower *ar = _ar.data();
-    uint32_t numBins = (uint32_t)_ar.size();
-    uint32_t stepSize = (uint32_t)_stepSize;
-    ar[0].setAttackTime(attack / stepSize);
-    ar[0].setReleaseTime(release / stepSize);
-    for (uint32_t i = 1; i < numBins; ++i)
-        ar[i].configureLike(ar[0]);
-}
-
-void SteppingAnalyzer::Smoother::clear()
-{
-    ARFollower *ar = _ar.data();
-    uint32_t numBins = (uint32_t)_ar.size();
-    for (uint32_t i = 0; i < numBins; ++i)
-        ar[i].clear();
-}
-
-void SteppingAnalyzer::Smoother::process(float *stepData)
-{
-    ARFollower *ar = _ar.data();
-    uint32_t numBins = (uint32_t)_ar.size();
-
-    uint32_t start = _binRange[0];
-    uint32_t end = std::min(_binRange[1], numBins);
-
-    for (uint32_t i = start; i < end; ++i)
-        stepData[i] = ar[i].compute(stepData[i]);
+    // once decayed to the floor, the magnitudes stay as they are, and there
+    // are no more frames until the silence ends
+    if (_silenceSettled)
+        return;
+
+    TRACE_SCOPE("silence");
+
+    const float floorDB = 20.0 * std::log10(kStftFloorMagnitude);
+    float *mags = getMagnitudes();
+    _smoother.processConstant(mags, floorDB, numSteps);
+
+    // the decay makes a frame on the frame steps only, the same ones as in
+    // the other channels, which count their frame phase alike; it's found
+    // settled on a frame, so that the last frame has the floor
+    if (!hasFrame)
+        return;
+
+    const uint32_t start = _binRange[0];
+    const uint32_t end = std::min(_binRange[1], getNumBins());
+    bool settled = true;
+    for (uint32_t i = start; i < end && settled; ++i)
+        settled = mags[i] - floorDB < kNegligibleDB;
+    // when the spectra are used elsewhere, for the M/S or the cross-spectra,
+    // what is made from them may still change after these magnitudes settle
+    _silenceSettled = settled && !_spectrumOnly && !_spectrumEveryStep;
+
+    advanceFrameCounter();
 }
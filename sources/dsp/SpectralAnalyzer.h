@@ -1,7 +1,8 @@
 #pragma once
 #include "AnalyzerDefs.h"
-#include "ARFollower.h"
+#include "Smoother.h"
 #include <vector>
+#include <complex>
 #include <cstdint>
 
 ///
@@ -24,6 +25,15 @@ protected:
 public:
     virtual void configure(const Configuration &config) = 0;
     virtual void setAttackAndRelease(float attack, float release) = 0;
+    // the minimum spacing of the frames which get observed, in samples; the
+    // analyzer is free to skip computing the steps in between
+    virtual void setFrameInterval(uint32_t numFrames) { (void)numFrames; }
+    // whether the steps skipped by the frame interval must still compute
+    // their complex spectrum, when the analyzer has one
+    virtual void setSpectrumEveryStep(bool enable) { (void)enable; }
+    // whether the frames compute only their complex spectrum, when the
+    // analyzer has one; the magnitudes stay at the floor
+    virtual void setSpectrumOnly(bool enable) { (void)enable; }
     virtual void clear();
     virtual void process(const float *input, uint32_t numFrames) = 0;
 
@@ -33,8 +43,26 @@ public:
     float *getMagnitudes() { return _mags.data(); }
     uint32_t getNumBins() const { return _numBins; }
 
+    // number of analysis frames produced so far, it changes every time
+    // the magnitudes are updated
+    uint32_t getFrameCounter() const { return _frameCounter; }
+
+    // the complex spectrum of the latest block analyzed, unsmoothed, on the
+    // bins of the magnitudes; null if the analyzer does not have one
+    virtual const std::complex<float> *getSpectrum() const { return nullptr; }
+
+    // number of complex spectra computed so far; it does not change on the
+    // steps which are skipped, such as silent ones
+    uint32_t getSpectrumCounter() const { return _spectrumCounter; }
+
+protected:
+    void advanceFrameCounter() { ++_frameCounter; }
+    void advanceSpectrumCounter() { ++_spectrumCounter; }
+
 private:
     uint32_t _numBins = 0;
+    uint32_t _frameCounter = 0;
+    uint32_t _spectrumCounter = 0;
     std::vector<float> _freqs;
     std::vector<float> _mags;
 };
@@ -51,15 +79,29 @@ public:
 
 protected:
     void configureStepping(uint32_t numBins, const Configuration &config);
+    // the analysis window, a Hann window unless the subclass replaces it
+    float *getWindow() { return _window.data(); }
 
 public:
     virtual void configureBinRange(uint32_t start, uint32_t end);
     virtual void setAttackAndRelease(float attack, float release) override;
+    virtual void setFrameInterval(uint32_t numFrames) override;
+    virtual void setSpectrumEveryStep(bool enable) override;
+    virtual void setSpectrumOnly(bool enable) override;
+    // whether the silent steps are skipped, which they are unless a check
+    // compares with the analysis of every step
+    void setSilenceSkipping(bool enable) { _silenceSkipping = enable; }
     virtual void clear() override;
     virtual void process(const float *input, uint32_t numFrames) override;
 
 protected:
     virtual void processNewBlock(float *input) = 0;
+    // computes only the complex spectrum of a windowed block, on a step whose
+    // magnitudes are skipped
+    virtual void processNewSpectrum(float *input) { (void)input; }
+
+private:
+    void processSilentSteps(uint32_t numSteps, bool hasFrame);
 
 private:
     // window
@@ -70,6 +112,14 @@ private:
     uint32_t _stepCounter {};
     uint32_t _stepSize {};
 
+    // decimation: steps to account for at the next computed one, and the
+    // position in the frame interval, which silent steps advance as well
+    uint32_t _frameInterval {};
+    uint32_t _pendingSteps {};
+    uint32_t _framePhase {};
+    bool _spectrumEveryStep = false;
+    bool _spectrumOnly = false;
+
     // input sample accumulation
     uint32_t _ringIndex {};
     std::vector<float> _ring;
@@ -77,21 +127,15 @@ private:
     // range
     uint32_t _binRange[2] = { 0u, ~0u };
 
+    // silence detection: count of the latest samples under the threshold,
+    // and whether the magnitudes have decayed to the floor
+    uint32_t _silentRun {};
+    bool _silenceSettled = false;
+    bool _silenceSkipping = true;
+
     // temporary
     std::vector<float> _input;
 
     // step-by-step smoother
-    class Smoother {
-    public:
-        void configure(uint32_t numBins, uint32_t stepSize, double attackTime, double releaseTime, double sampleRate);
-        void configureBinRange(uint32_t start, uint32_t end);
-        void setAttackAndRelease(float attack, float release);
-        void clear();
-        void process(float *stepData);
-    private:
-        std::vector<ARFollower> _ar;
-        uint32_t _stepSize = 0;
-        uint32_t _binRange[2] = { 0u, ~0u };
-    };
     Smoother _smoother;
 };
@@ -0,0 +1,55 @@
+#include "SpectralPeaks.h"
+#include "AnalyzerDefs.h"
+#include <algorithm>
+
+// fits y = a*u^2 + b*u + y1, where u is the distance to the center bin
+static void refinePeak(const float *freqs, const float *mags, uint32_t i, SpectralPeak &pk)
+{
+    const double y1 = mags[i];
+    const double y0 = mags[i - 1];
+    const double y2 = mags[i + 1];
+    const double d0 = (double)freqs[i - 1] - freqs[i];
+    const double d2 = (double)freqs[i + 1] - freqs[i];
+    const double s0 = (y0 - y1) / d0;
+    const double s2 = (y2 - y1) / d2;
+    const double a = (s2 - s0) / (d2 - d0);
+    const double b = s0 - a * d0;
+
+    if (a < 0) {
+        double u = -b / (2 * a);
+        u = (u < d0) ? d0 : (u > d2) ? d2 : u;
+        pk.frequency = freqs[i] + u;
+        pk.magnitude = y1 + u * (b + a * u);
+    }
+    else {
+        pk.frequency = freqs[i];
+        pk.magnitude = y1;
+    }
+}
+
+uint32_t findSpectralPeaks(const float *freqs, const float *mags, uint32_t numBins, SpectralPeak *peaks)
+{
+    const float floor = kStftFloorMagnitudeInDB + kNegligibleDB;
+    uint32_t numPeaks = 0;
+
+    // the maxima are marked a block at a time, in a loop without branches
+    // which vectorizes along the bins, and only those are refined
+    enum { kBlockSize = 256 };
+    uint8_t isPeak[kBlockSize];
+
+    for (uint32_t start = 1; start + 1 < numBins; start += kBlockSize) {
+        const uint32_t count = std::min<uint32_t>(kBlockSize, numBins - 1 - start);
+        const float *y = &mags[start];
+        const float *prev = y - 1;
+        const float *next = y + 1;
+        for (uint32_t j = 0; j < count; ++j)
+            isPeak[j] = (y[j] > floor) & (y[j] >= prev[j]) & (y[j] > next[j]);
+
+        for (uint32_t j = 0; j < count; ++j) {
+            if (isPeak[j])
+                refinePeak(freqs, mags, start + j, peaks[numPeaks++]);
+        }
+    }
+
+    return numPeaks;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+struct SpectralPeak {
+    float frequency;
+    float magnitude;
+};
+
+///
+// Finds the local maxima of a spectrum in decibels which rise above the
+// floor, in order of frequency. Each one is refined by a parabola through the
+// maximum and its neighbors, which works also with unevenly spaced bins.
+// The output needs room for `numBins / 2` peaks; returns the peak count.
+uint32_t findSpectralPeaks(const float *freqs, const float *mags, uint32_t numBins, SpectralPeak *peaks);
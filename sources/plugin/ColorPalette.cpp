@@ -1,9 +1,59 @@
 #include "ColorPalette.h"
 #include "Config.h"
 #include <unordered_set>
+#include <vector>
+#include <string>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
 
+static constexpr unsigned kNumChannels = DISTRHO_PLUGIN_NUM_INPUTS;
+
+///
+static std::vector<std::string> make_color_names()
+{
+    std::vector<std::string> names(Colors::Count);
+
+    names[Colors::text_normal] = "text-normal";
+    names[Colors::text_active] = "text-active";
+    names[Colors::spectrum_background] = "spectrum-background";
+    names[Colors::spectrum_grid_text] = "spectrum-grid-text";
+    names[Colors::spectrum_grid_lines] = "spectrum-grid-lines";
+    names[Colors::spectrum_minor_grid_lines] = "spectrum-minor-grid-lines";
+    names[Colors::spectrum_line_coherence] = "spectrum-line-coherence";
+    names[Colors::spectrum_line_phase] = "spectrum-line-phase";
+    names[Colors::spectrum_line_transfer] = "spectrum-line-transfer";
+    names[Colors::spectrum_line_mid] = "spectrum-line-mid";
+    names[Colors::spectrum_line_side] = "spectrum-line-side";
+    names[Colors::spectrum_select_line] = "spectrum-select-line";
+    names[Colors::slider_back] = "slider-back";
+    names[Colors::slider_fill] = "slider-fill";
+    names[Colors::spin_box_back] = "spin-box-back";
+    names[Colors::spin_box_fill] = "spin-box-fill";
+    names[Colors::floating_window_back] = "floating-window-back";
+    names[Colors::tool_bar_back] = "tool-bar-back";
+    names[Colors::selection_rectangle] = "selection-rectangle";
+    names[Colors::resize_handle] = "resize-handle";
+
+    for (unsigned c = 0; c < kNumChannels; ++c) {
+        const std::string number = std::to_string(c + 1);
+        names[Colors::text_channel1 + c] = "text-channel" + number;
+        names[Colors::spectrum_line_channel1 + c] = "spectrum-line-channel" + number;
+        names[Colors::spectrum_fill_channel1 + c] = "spectrum-fill-channel" + number;
+    }
+
+    return names;
+}
+
+const char *Colors::get_name(size_t index)
+{
+    static const std::vector<std::string> names = make_color_names();
+
+    assert(index < Colors::Count && !names[index].empty());
+    return names[index].c_str();
+}
+
+///
 ColorPalette::ColorPalette()
     : colors_{new ColorRGBA8[Colors::Count]{}}
 {
@@ -91,7 +141,7 @@ bool ColorPalette::load(const CSimpleIniA &ini, const char *section)
 
         unsigned index = ~0u;
         for (unsigned i = 0; i < Colors::Count && index == ~0u; ++i) {
-            if (std::strcmp(key, Colors::Name[i]) == 0)
+            if (std::strcmp(key, Colors::get_name(i)) == 0)
                 index = i;
         }
 
@@ -134,7 +184,16 @@ bool ColorPalette::load(const CSimpleIniA &ini, const char *section)
 void ColorPalette::save_defaults(CSimpleIniA &ini, const char *section, bool overwrite)
 {
     auto fill_color = [&ini, section, overwrite](int color, const char *value, const char *comment) {
-        ini.SetValue(section, Colors::Name[color], value, comment, overwrite);
+        ini.SetValue(section, Colors::get_name(color), value, comment, overwrite);
+    };
+
+    // the channels past the first two spread around the hue circle
+    auto fill_channel_colors = [&fill_color](unsigned channel, float hue) {
+        const std::string line = hex_from_color(Colors::toRGBA8(Colors::fromHSV(hue, 0.9f, 0.95f)));
+        const std::string text = hex_from_color(Colors::toRGBA8(Colors::fromHSV(hue, 0.5f, 0.9f)));
+        fill_color(Colors::text_channel1 + channel, text.c_str(), nullptr);
+        fill_color(Colors::spectrum_line_channel1 + channel, line.c_str(), nullptr);
+        fill_color(Colors::spectrum_fill_channel1 + channel, (line + "00").c_str(), nullptr);
     };
 
     fill_color(Colors::text_normal, "#e0e0e0", nullptr);
@@ -153,6 +212,13 @@ void ColorPalette::save_defaults(CSimpleIniA &ini, const char *section, bool ove
     fill_color(Colors::spectrum_fill_channel1, "#00ff0000", nullptr);
     fill_color(Colors::spectrum_line_channel1 + 1, "#e88710", nullptr);
     fill_color(Colors::spectrum_fill_channel1 + 1, "#e8871000", nullptr);
+    for (unsigned c = 2; c < kNumChannels; ++c)
+        fill_channel_colors(c, std::fmod(0.55f + 0.382f * (c - 2), 1.0f));
+    fill_color(Colors::spectrum_line_coherence, "#40c0ff", nullptr);
+    fill_color(Colors::spectrum_line_phase, "#ff60c0", nullptr);
+    fill_color(Colors::spectrum_line_transfer, "#ffff40", nullptr);
+    fill_color(Colors::spectrum_line_mid, "#f0f0f0", nullptr);
+    fill_color(Colors::spectrum_line_side, "#a070ff", nullptr);
 
     fill_color(Colors::spectrum_select_line, "#ffffffc0", nullptr);
 
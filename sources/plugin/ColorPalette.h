@@ -5,14 +5,6 @@
 #include <memory>
 #include <cassert>
 
-#if !defined(maybe_unused)
-#   if defined(__GNUC__)
-#       define maybe_unused __attribute__((unused))
-#   else
-#       define maybe_unused
-#   endif
-#endif
-
 struct ColorPalette
 {
     ColorPalette();
@@ -47,6 +39,11 @@ namespace Colors {
         spectrum_line_channelN = spectrum_line_channel1 + DISTRHO_PLUGIN_NUM_INPUTS - 1,
         spectrum_fill_channel1,
         spectrum_fill_channelN = spectrum_fill_channel1 + DISTRHO_PLUGIN_NUM_INPUTS - 1,
+        spectrum_line_coherence,
+        spectrum_line_phase,
+        spectrum_line_transfer,
+        spectrum_line_mid,
+        spectrum_line_side,
         spectrum_select_line,
         slider_back,
         slider_fill,
@@ -56,37 +53,11 @@ namespace Colors {
         tool_bar_back,
         selection_rectangle,
         resize_handle,
+        Count
     };
 
-    maybe_unused static const char *Name[] = {
-        "text-normal",
-        "text-active",
-        "text-channel1",
-        "text-channel2",
-        "spectrum-background",
-        "spectrum-grid-text",
-        "spectrum-grid-lines",
-        "spectrum-minor-grid-lines",
-        "spectrum-line-channel1",
-        "spectrum-line-channel2",
-        "spectrum-fill-channel1",
-        "spectrum-fill-channel2",
-        "spectrum-select-line",
-        "slider-back",
-        "slider-fill",
-        "spin-box-back",
-        "spin-box-fill",
-        "floating-window-back",
-        "tool-bar-back",
-        "selection-rectangle",
-        "resize-handle",
-        #if DISTRHO_PLUGIN_NUM_INPUTS != 2
-        #  error currently the name list assumes channels = 2
-        #endif
-    };
-
-    maybe_unused static constexpr size_t Count =
-        sizeof(Name) / sizeof(Name[0]);
+    // name of a color in the themes
+    const char *get_name(size_t index);
 }
 
 inline ColorRGBA8 &ColorPalette::operator[](size_t index) noexcept
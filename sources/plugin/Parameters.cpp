@@ -56,5 +56,48 @@ void InitParameter(uint32_t index, Parameter &parameter)
             pev[i].value = i;
         }
         break;
+    case kPidChannelMode:
+        parameter.hints = kParameterIsInteger;
+        parameter.name = "Channel mode";
+        parameter.symbol = "channel_mode";
+        parameter.ranges = ParameterRanges(kDefaultChannelMode, 0, kNumChannelModes - 1);
+        parameter.enumValues.count = kNumChannelModes;
+        parameter.enumValues.values = pev = new ParameterEnumerationValue[kNumChannelModes];
+        for (uint32_t i = 0; i < kNumChannelModes; ++i) {
+            pev[i].label = String(getChannelModeName((ChannelMode)i));
+            pev[i].value = i;
+        }
+        break;
+    case kPidDspLoad:
+        parameter.hints = kParameterIsOutput;
+        parameter.name = "DSP load";
+        parameter.symbol = "dsp_load";
+        parameter.ranges = ParameterRanges(0, 0, 100);
+        parameter.unit = "%";
+        break;
+    case kPidDspPeakLoad:
+        parameter.hints = kParameterIsOutput;
+        parameter.name = "DSP peak load";
+        parameter.symbol = "dsp_peak_load";
+        parameter.ranges = ParameterRanges(0, 0, 100);
+        parameter.unit = "%";
+        break;
+    }
+}
+
+void InitState(uint32_t index, State &state)
+{
+    // messages of the running session, which the host has no use to save
+    state.hints = kStateIsOnlyForUI;
+
+    switch (index) {
+    case kSidEditor:
+        state.key = "editor";
+        state.defaultValue = "0 0 0";
+        break;
+    case kSidFrame:
+        state.key = "frame";
+        state.defaultValue = "";
+        break;
     }
 }
@@ -7,7 +7,24 @@ enum {
     kPidAttackTime,
     kPidReleaseTime,
     kPidAlgorithm,
+    kPidChannelMode,
+    kPidDspLoad,
+    kPidDspPeakLoad,
     kParameterCount,
 };
 
+// the messages between the plugin and an editor which can't access it
+// directly, such as one in another process
+enum {
+    kSidEditor, // editor to plugin: "<visible> <refresh interval> <serial>"
+    kSidFrame, // plugin to editor: an encoded frame, see SpectrumTransport
+    kStateCount,
+};
+
+// an open editor repeats its message at this interval, and one which stays
+// silent for the timeout is taken as gone, closed or crashed
+static constexpr double kEditorStateInterval = 1.0;
+static constexpr double kEditorStateTimeout = 3 * kEditorStateInterval;
+
 void InitParameter(uint32_t index, Parameter &parameter);
+void InitState(uint32_t index, State &state);
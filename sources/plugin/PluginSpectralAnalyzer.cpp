@@ -27,18 +27,29 @@
 #include "PluginSpectralAnalyzer.hpp"
 #include "Parameters.h"
 #include "dsp/STFT.h"
-#include "dsp/MultirateSTFT.h"
+#include "dsp/AnalyzerFactory.h"
 #include "dsp/AnalyzerDefs.h"
 #include "dsp/FFTPlanner.h"
+#include "util/trace_events.h"
+#include "util/realtime_checker.h"
 #include "blink/DenormalDisabler.h"
 #include <memory>
+#include <algorithm>
 #include <cstring>
+#include <cstdio>
+#include <cmath>
+
+// the port which passes the states has room for a fragment of frame
+static_assert(kFrameFragmentSize + 1024 <= DISTRHO_PLUGIN_MINIMUM_BUFFER_SIZE,
+              "the buffer size is too small for the frame fragments");
 
 PluginSpectralAnalyzer::PluginSpectralAnalyzer()
-    : Plugin(kParameterCount, 0, 0),
+    : Plugin(kParameterCount, 0, kStateCount),
       fParameters(new float[kParameterCount]),
       fParameterRanges(new ParameterRanges[kParameterCount])
 {
+    trace_init();
+
     for (uint32_t c = 0; c < kNumChannels; ++c)
         fStft[c].reset(new STFT);
 
@@ -50,19 +61,25 @@ PluginSpectralAnalyzer::PluginSpectralAnalyzer()
     }
 
     constexpr uint32_t specMaxSize = kStftMaxSize / 2 + 1;
-    fSendFrequencies.resize(kNumChannels * specMaxSize);
-    fSendMagnitudes.resize(kNumChannels * specMaxSize);
+    fSendFrequencies.resize(kMaxCurves * specMaxSize);
+    fSendMagnitudes.resize(kMaxCurves * specMaxSize);
+    fShared.open(kNumChannels, specMaxSize, kMaxCurves);
+    fEncoder.configure(kNumChannels, specMaxSize, kMaxCurves);
 
-    sampleRateChanged(getSampleRate());
+    fWorker = WorkerService::acquire();
+    fWorkerTask = fWorker->addTask([this]() { runWorkerTask(); });
 
-    fThread = std::thread([this]() { runThread(); });
+    sampleRateChanged(getSampleRate());
 }
 
 PluginSpectralAnalyzer::~PluginSpectralAnalyzer()
 {
-    fThreadQuit = true;
-    fThreadSem.post();
-    fThread.join();
+    fWorker->removeTask(fWorkerTask);
+
+    if (unsigned violations = rt_checker_violations())
+        d_stderr("Realtime violations in the audio thread: %u", violations);
+
+    trace_shutdown();
 }
 
 // -----------------------------------------------------------------------
@@ -85,6 +102,12 @@ void PluginSpectralAnalyzer::initProgramName(uint32_t index, String &programName
     DISTRHO_SAFE_ASSERT(false);
 }
 
+void PluginSpectralAnalyzer::initState(uint32_t index, State &state)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(index < kStateCount, );
+    InitState(index, state);
+}
+
 // -----------------------------------------------------------------------
 // Internal data
 
@@ -94,7 +117,8 @@ void PluginSpectralAnalyzer::initProgramName(uint32_t index, String &programName
 void PluginSpectralAnalyzer::sampleRateChanged(double newSampleRate)
 {
     fSampleRate = newSampleRate;
-    fThreadSem.post();
+    fMustReconfigure.store(true);
+    fWorker->post(fWorkerTask);
 }
 
 /**
@@ -112,6 +136,9 @@ float PluginSpectralAnalyzer::getParameterValue(uint32_t index) const
 void PluginSpectralAnalyzer::setParameterValue(uint32_t index, float value)
 {
     DISTRHO_SAFE_ASSERT_RETURN(index < kParameterCount, );
+
+    if (index == kPidDspLoad || index == kPidDspPeakLoad)
+        return;
     fParameterRanges[index].fixValue(value);
     fParameters[index] = value;
 
@@ -119,7 +146,9 @@ void PluginSpectralAnalyzer::setParameterValue(uint32_t index, float value)
     case kPidFftSize:
     case kPidStepSize:
     case kPidAlgorithm:
-        fThreadSem.post();
+    case kPidChannelMode:
+        fMustReconfigure.store(true);
+        fWorker->post(fWorkerTask);
         break;
     case kPidAttackTime:
     case kPidReleaseTime:
@@ -128,6 +157,12 @@ void PluginSpectralAnalyzer::setParameterValue(uint32_t index, float value)
     }
 }
 
+void PluginSpectralAnalyzer::setEditorRefreshInterval(double interval)
+{
+    fEditorRefreshInterval.store(interval);
+    fMustReconfigureFrameInterval.store(true);
+}
+
 /**
   Load a program.
   The host may call this function from any context,
@@ -139,6 +174,40 @@ void PluginSpectralAnalyzer::loadProgram(uint32_t index)
     DISTRHO_SAFE_ASSERT(false);
 }
 
+/**
+  Change an internal state.
+*/
+void PluginSpectralAnalyzer::setState(const char *key, const char *value)
+{
+    // the frames are only sent, whatever comes back is ignored
+    if (std::strcmp(key, "editor") != 0)
+        return;
+
+    unsigned visible = 0;
+    double interval = 0;
+    unsigned serial = 0;
+    if (std::sscanf(value, "%u %lf %u", &visible, &interval, &serial) != 3)
+        return;
+
+    // a live editor numbers its messages in sequence, whereas a value which
+    // the host restores repeats an old one, and is ignored
+    const bool inSequence = fEditorSerialValid && serial == fEditorSerial + 1;
+    fEditorSerial = serial;
+    fEditorSerialValid = true;
+    if (!inSequence)
+        return;
+
+    // only an editor without direct access tells its status this way, and
+    // it stops receiving frames when closed, or when it stops telling
+    fEditorMessageReceived.store(true);
+    fEditorIsRemote.store(visible != 0);
+    if (interval > 0)
+        setEditorRefreshInterval(interval);
+    if (visible && !fEditorVisible)
+        fMustSendKeyFrame.store(true);
+    setEditorIsVisible(visible != 0);
+}
+
 // -----------------------------------------------------------------------
 // Process
 
@@ -146,22 +215,35 @@ void PluginSpectralAnalyzer::activate()
 {
     fComputationStarts = true;
 
-#if !defined(SKIP_FFT_PRECACHING)
-    // precache FFT plans for quicker use
-    for (uint32_t sizeLog2 = kStftMinSizeLog2; sizeLog2 <= kStftMaxSizeLog2; ++sizeLog2) {
-        uint32_t size = 1u << sizeLog2;
-        FFTPlanner::getInstance().forwardFFT(size);
-    }
-#endif
+    // a remote editor tells again that it's there, if it is
+    fEditorIsRemote.store(false);
 
-    fThreadSem.post();
+    fMustReconfigure.store(true);
+    fMustPrecachePlans.store(true);
+    fWorker->post(fWorkerTask);
 }
 
 void PluginSpectralAnalyzer::run(const float **inputs, float **outputs, uint32_t frames)
 {
     WebCore::DenormalDisabler dd;
 
-    bool computationShouldBeActive = fEditorVisible;
+    RT_CHECKER_SCOPE();
+    TRACE_THREAD_NAME("audio");
+    TRACE_SCOPE("run");
+
+    const std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+
+    // a remote editor repeats its status while open, one which stopped is
+    // gone without having told, or its last message was lost
+    if (fEditorMessageReceived.exchange(false) || !fEditorIsRemote.load(std::memory_order_relaxed))
+        fFramesSinceEditorMessage = 0;
+    else if ((fFramesSinceEditorMessage += frames) > kEditorStateTimeout * fSampleRate) {
+        fEditorIsRemote.store(false);
+        setEditorIsVisible(false);
+    }
+
+    // the published frames are wanted even if nobody looks at the editor
+    bool computationShouldBeActive = fEditorVisible || fShared.isOpen();
 
     if (fComputationIsActive != computationShouldBeActive) {
         fComputationIsActive = computationShouldBeActive;
@@ -177,44 +259,110 @@ void PluginSpectralAnalyzer::run(const float **inputs, float **outputs, uint32_t
                 for (uint32_t c = 0; c < kNumChannels; ++c) {
                     BasicAnalyzer &stft = *fStft[c];
                     stft.clear();
+                    fSpectrumCounters[c] = stft.getSpectrumCounter();
                 }
+                fCrossSpectrum.clear();
+                fMidSide.clear();
+                fStepPhase = 0;
+                fFramePhase = 0;
+                fPendingSteps = 0;
+                fSentFrameCounter = ~0u;
                 fComputationStarts = false;
             }
 
             if (fMustReconfigureEnvelope.exchange(false)) {
                 for (uint32_t c = 0; c < kNumChannels; ++c)
                     fStft[c]->setAttackAndRelease(fParameters[kPidAttackTime], fParameters[kPidReleaseTime]);
+                fCrossSpectrum.setAveragingTime(fParameters[kPidReleaseTime]);
+                fMidSide.setAttackAndRelease(fParameters[kPidAttackTime], fParameters[kPidReleaseTime]);
             }
 
-            for (uint32_t c = 0; c < kNumChannels; ++c) {
-                BasicAnalyzer &stft = *fStft[c];
-                const float *input = inputs[c];
-                stft.process(input, frames);
+            if (fMustReconfigureFrameInterval.exchange(false)) {
+                const uint32_t frameInterval = getAnalysisFrameInterval();
+                for (uint32_t c = 0; c < kNumChannels; ++c)
+                    fStft[c]->setFrameInterval(frameInterval);
+                fFrameInterval = frameInterval;
             }
 
-            std::unique_lock<SpinMutex> sendLock(fSendMutex, std::try_to_lock);
-            if (sendLock.owns_lock()) {
-                uint32_t numBins;
-                const float* freqs[kNumChannels] = {};
-                const float* mags[kNumChannels] = {};
+            if (fEditorIsRemote.load(std::memory_order_relaxed))
+                fFramesSinceEncoded += frames;
 
-                numBins = fStft[0]->getNumBins();
-                for (uint32_t c = 0; c < kNumChannels; ++c) {
-                    BasicAnalyzer &stft = *fStft[c];
-                    freqs[c] = stft.getFrequencies();
-                    mags[c] = stft.getMagnitudes();
+            // the wrapper passed the last fragment to the host at the end of
+            // the previous cycle, the one which saw it first
+            if (fFrameState.load(std::memory_order_acquire) == kFrameAwaitingCycle && ++fFrameCyclesWaited >= 2) {
+                fFrameCyclesWaited = 0;
+                if (fFrameFragment < fFrameNumFragments) {
+                    fFrameState.store(kFrameReady, std::memory_order_release);
+                    fWorker->post(fWorkerTask);
                 }
+                else
+                    fFrameState.store(kFrameIdle, std::memory_order_release);
+            }
 
+            if (fChannelMode == kChannelModeLeftRight) {
                 for (uint32_t c = 0; c < kNumChannels; ++c) {
-                    fSendSize = numBins;
-                    std::memcpy(
-                        &fSendFrequencies[c * numBins], freqs[c],
-                        numBins * sizeof(float));
-                    std::memcpy(
-                        &fSendMagnitudes[c * numBins], mags[c],
-                        numBins * sizeof(float));
+                    BasicAnalyzer &stft = *fStft[c];
+                    const float *input = inputs[c];
+                    stft.process(input, frames);
                 }
             }
+            else
+                processInLockstep(inputs, frames);
+
+            // all channels have their frames on the same steps, except those
+            // whose silence has settled, which have none; any other tells
+            // when there is a new frame; if the UI holds the lock, retry later
+            uint32_t frameCounter = 0;
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+                frameCounter += fStft[c]->getFrameCounter();
+            std::unique_lock<SpinMutex> sendLock(fSendMutex, std::defer_lock);
+            if (frameCounter != fSentFrameCounter && sendLock.try_lock()) {
+                const ChannelMode channelMode = fChannelMode;
+                const uint32_t numBins = fStft[0]->getNumBins();
+                const uint32_t numCurves = getNumCurves(channelMode, kNumChannels);
+                fSendSize = numBins;
+                fSendNumCurves = numCurves;
+                fSendChannelMode = channelMode;
+
+                for (uint32_t c = 0; c < numCurves; ++c) {
+                    // curves past the channels are on the bins of the first
+                    const BasicAnalyzer &stft = *fStft[(c < kNumChannels) ? c : 0];
+                    float *freqs = &fSendFrequencies[c * numBins];
+                    float *mags = &fSendMagnitudes[c * numBins];
+                    std::memcpy(freqs, stft.getFrequencies(), numBins * sizeof(float));
+
+                    switch (getCurveKind(channelMode, kNumChannels, c)) {
+                    case kCurveMagnitude:
+                        switch (getCurveSignal(channelMode, kNumChannels, c)) {
+                        case kSignalChannel:
+                            std::memcpy(mags, stft.getMagnitudes(), numBins * sizeof(float));
+                            break;
+                        case kSignalMid:
+                            std::memcpy(mags, fMidSide.getMidMagnitudes(), numBins * sizeof(float));
+                            break;
+                        case kSignalSide:
+                            std::memcpy(mags, fMidSide.getSideMagnitudes(), numBins * sizeof(float));
+                            break;
+                        }
+                        break;
+                    case kCurveCoherence:
+                        fCrossSpectrum.computeCoherence(mags);
+                        break;
+                    case kCurvePhase:
+                        fCrossSpectrum.computePhase(mags);
+                        break;
+                    case kCurveGain:
+                        fCrossSpectrum.computeTransferGain(mags);
+                        break;
+                    }
+                }
+                fShared.publish(fSampleRate, channelMode, numBins, numCurves, fSendFrequencies.data(), fSendMagnitudes.data());
+                if (fEditorIsRemote.load(std::memory_order_relaxed))
+                    encodeForRemoteEditor(fSendFrequencies.data(), fSendMagnitudes.data(), numBins, numCurves);
+
+                ++fSendGeneration;
+                fSentFrameCounter = frameCounter;
+            }
         }
     }
 
@@ -222,60 +370,209 @@ void PluginSpectralAnalyzer::run(const float **inputs, float **outputs, uint32_t
         if (inputs[c] != outputs[c])
             std::memcpy(outputs[c], inputs[c], frames * sizeof(float));
     }
+
+    const std::chrono::steady_clock::time_point runEnd = std::chrono::steady_clock::now();
+    updateDspLoad(std::chrono::duration<double>(runEnd - runStart).count(), frames);
+}
+
+void PluginSpectralAnalyzer::processInLockstep(const float **inputs, uint32_t frames)
+{
+    // the channels advance together up to the end of each step, where the
+    // spectra of the step are all available; a channel without a new one
+    // was found silent
+    const uint32_t stepSize = fStepSize;
+    const uint32_t stepsPerFrame = std::max(1u, fFrameInterval / stepSize);
+    const ChannelMode channelMode = fChannelMode;
+
+    for (uint32_t index = 0; index < frames; ) {
+        const uint32_t count = std::min(frames - index, stepSize - fStepPhase);
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            fStft[c]->process(inputs[c] + index, count);
+        index += count;
+
+        fStepPhase += count;
+        if (fStepPhase < stepSize)
+            continue;
+        fStepPhase = 0;
+
+        // the frames are on the same steps as in the analyzers
+        ++fPendingSteps;
+        const bool isFrame = ++fFramePhase >= stepsPerFrame;
+        if (isFrame)
+            fFramePhase = 0;
+
+        const std::complex<float> *spectra[kNumChannels];
+        for (uint32_t c = 0; c < kNumChannels; ++c) {
+            const BasicAnalyzer &stft = *fStft[c];
+            const uint32_t counter = stft.getSpectrumCounter();
+            spectra[c] = (counter != fSpectrumCounters[c]) ? stft.getSpectrum() : nullptr;
+            fSpectrumCounters[c] = counter;
+        }
+
+        if (hasCrossSpectrum(channelMode)) {
+            TRACE_SCOPE("cross spectrum");
+            fCrossSpectrum.process(spectra[0], spectra[1]);
+        }
+
+        if (hasMidSide(channelMode) && isFrame) {
+            TRACE_SCOPE("mid side");
+            fMidSide.process(spectra[0], spectra[1], fPendingSteps);
+            fPendingSteps = 0;
+        }
+    }
+}
+
+void PluginSpectralAnalyzer::encodeForRemoteEditor(const float *frequencies, const float *magnitudes, uint32_t numBins, uint32_t numCurves)
+{
+    // the frames come twice per refresh, to be found by each; going through
+    // the host, they'd better be only as many as shown
+    const double interval = fEditorRefreshInterval.load();
+    if (fFramesSinceEncoded < interval * fSampleRate)
+        return;
+
+    // the worker is still sending the previous one
+    if (fFrameState.load(std::memory_order_acquire) != kFrameIdle)
+        return;
+    fFramesSinceEncoded = 0;
+
+    if (fMustSendKeyFrame.exchange(false))
+        fEncoder.requestKeyFrame();
+
+    TRACE_SCOPE("encode frame");
+    if (fEncoder.encode(fChannelMode, numBins, numCurves, frequencies, magnitudes)) {
+        fFrameFragment = 0;
+        fFrameNumFragments = fEncoder.getNumFragments();
+        fFrameState.store(kFrameReady, std::memory_order_release);
+        fWorker->post(fWorkerTask);
+    }
+}
+
+void PluginSpectralAnalyzer::sendFrameFragment()
+{
+    if (fFrameState.load(std::memory_order_acquire) != kFrameReady)
+        return;
+
+    // the wrapper stores the value, then flags it for sending; it reads the
+    // value in its process callback, after run(), only while it's flagged,
+    // and the previous has been sent at least one cycle ago, unflagging it
+    TRACE_SCOPE("send frame");
+    const uint32_t index = fFrameFragment++;
+    updateStateValue("frame", fEncoder.getFragment(index));
+
+    // even after the last, for the next frame to wait until it's passed
+    fFrameState.store(kFrameAwaitingCycle, std::memory_order_release);
+}
+
+uint32_t PluginSpectralAnalyzer::getAnalysisFrameInterval() const
+{
+    // twice as many frames as the editor refreshes, so that each refresh
+    // finds a new frame even though the two are not in phase
+    return (uint32_t)(0.5 * fEditorRefreshInterval.load() * fSampleRate);
+}
+
+void PluginSpectralAnalyzer::updateDspLoad(double elapsed, uint32_t frames)
+{
+    if (frames == 0)
+        return;
+
+    const double sampleRate = fSampleRate;
+    const double load = elapsed * sampleRate / frames;
+
+    // average over about 300 ms, and let the peak fall within a few seconds
+    const double averageCoef = std::exp(-frames / (0.3 * sampleRate));
+    const double peakCoef = std::exp(-frames / (2.0 * sampleRate));
+
+    fDspLoad = load + averageCoef * (fDspLoad - load);
+    fDspPeakLoad = std::max(load, peakCoef * fDspPeakLoad);
+
+    fParameters[kPidDspLoad] = std::min(100.0, 100.0 * fDspLoad);
+    fParameters[kPidDspPeakLoad] = std::min(100.0, 100.0 * fDspPeakLoad);
 }
 
 // -----------------------------------------------------------------------
 
-void PluginSpectralAnalyzer::runThread()
+void PluginSpectralAnalyzer::reconfigure()
 {
-    for (;;) {
-        for (fThreadSem.wait(); fThreadSem.try_wait(); );
+    TRACE_SCOPE("reconfigure");
 
-        if (fThreadQuit)
-            break;
+    std::lock_guard<SpinMutex> lock(fStftMutex);
 
-        std::lock_guard<SpinMutex> lock(fStftMutex);
+    Configuration config;
+    config.sampleRate = fSampleRate;
+    config.windowSize = 1u << (uint32_t)fParameters[kPidFftSize];
+    config.stepSize = 1u << (uint32_t)fParameters[kPidStepSize];
+    config.attackTime = fParameters[kPidAttackTime];
+    config.releaseTime = fParameters[kPidReleaseTime];
 
-        Configuration config;
-        config.sampleRate = fSampleRate;
-        config.windowSize = 1u << (uint32_t)fParameters[kPidFftSize];
-        config.stepSize = 1u << (uint32_t)fParameters[kPidStepSize];
-        config.attackTime = fParameters[kPidAttackTime];
-        config.releaseTime = fParameters[kPidReleaseTime];
+    // the modes other than L/R need the complex spectra of the STFT
+    const ChannelMode channelMode = (ChannelMode)fParameters[kPidChannelMode];
+    const Algorithm algorithm = (channelMode == kChannelModeLeftRight) ?
+        (Algorithm)fParameters[kPidAlgorithm] : kAlgoStft;
+    fChannelMode = channelMode;
 
-        for (uint32_t c = 0; c < kNumChannels; ++c) {
-            BasicAnalyzer *stft;
-            switch ((Algorithm)fParameters[kPidAlgorithm]) {
-            case kAlgoStft: default:
-                stft = new STFT;
-                break;
-            case kAlgoMultirateStftX2:
-                stft = new MultirateSTFT<2>;
-                break;
-            case kAlgoMultirateStftX3:
-                stft = new MultirateSTFT<3>;
-                break;
-            case kAlgoMultirateStftX4:
-                stft = new MultirateSTFT<4>;
-                break;
-            case kAlgoMultirateStftX5:
-                stft = new MultirateSTFT<5>;
-                break;
-            case kAlgoMultirateStftX6:
-                stft = new MultirateSTFT<6>;
-                break;
-            case kAlgoMultirateStftX7:
-                stft = new MultirateSTFT<7>;
-                break;
-            case kAlgoMultirateStftX8:
-                stft = new MultirateSTFT<8>;
-                break;
-            }
-            fStft[c].reset(stft);
-            stft->configure(config);
-            stft->clear();
+    const uint32_t frameInterval = getAnalysisFrameInterval();
+    fFrameInterval = frameInterval;
+
+    for (uint32_t c = 0; c < kNumChannels; ++c) {
+        BasicAnalyzer *stft = createAnalyzer(algorithm);
+        fStft[c].reset(stft);
+        stft->configure(config);
+        stft->setFrameInterval(frameInterval);
+        // the cross-spectra average the spectra of every step, even
+        // those whose magnitudes are skipped
+        stft->setSpectrumEveryStep(hasCrossSpectrum(channelMode));
+        // the M/S mode does without the magnitudes of the channels
+        stft->setSpectrumOnly(channelMode == kChannelModeMidSide);
+        stft->clear();
+        fSpectrumCounters[c] = stft->getSpectrumCounter();
+    }
+
+    // the multirate analyzers can have more bins than a single STFT
+    const uint32_t numBins = fStft[0]->getNumBins();
+    if (fSendFrequencies.size() < kMaxCurves * numBins) {
+        std::lock_guard<SpinMutex> sendLock(fSendMutex);
+        fSendFrequencies.resize(kMaxCurves * numBins);
+        fSendMagnitudes.resize(kMaxCurves * numBins);
+        fEncoder.configure(kNumChannels, numBins, kMaxCurves);
+        // the frame being sent is gone with the buffers; a fragment set
+        // already is still waited for
+        fFrameNumFragments = 0;
+        if (fFrameState.load(std::memory_order_acquire) == kFrameReady)
+            fFrameState.store(kFrameIdle, std::memory_order_release);
+    }
+    // the frequencies may have changed
+    fEncoder.requestKeyFrame();
+    fShared.reserve(numBins, kMaxCurves);
+
+    fCrossSpectrum.configure(numBins, config.windowSize, config.stepSize, config.sampleRate);
+    fCrossSpectrum.setAveragingTime(config.releaseTime);
+    fMidSide.configure(config);
+    fStepSize = config.stepSize;
+    fStepPhase = 0;
+    fFramePhase = 0;
+    fPendingSteps = 0;
+
+    fSentFrameCounter = ~0u;
+}
+
+void PluginSpectralAnalyzer::runWorkerTask()
+{
+    // the frame goes out before any reconfiguration, which may discard it
+    sendFrameFragment();
+
+    if (fMustReconfigure.exchange(false))
+        reconfigure();
+
+#if !defined(SKIP_FFT_PRECACHING)
+    // precache FFT plans for quicker use, once the analyzers are ready
+    if (fMustPrecachePlans.exchange(false)) {
+        TRACE_SCOPE("precache plans");
+        for (uint32_t sizeLog2 = kStftMinSizeLog2; sizeLog2 <= kStftMaxSizeLog2; ++sizeLog2) {
+            uint32_t size = 1u << sizeLog2;
+            FFTPlanner::getInstance().forwardFFT(size);
         }
     }
+#endif
 }
 
 // -----------------------------------------------------------------------
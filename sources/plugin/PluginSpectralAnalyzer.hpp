@@ -27,12 +27,17 @@
 #pragma once
 #include "DistrhoPlugin.hpp"
 #include "dsp/SpectralAnalyzer.h"
+#include "dsp/CrossSpectrum.h"
+#include "dsp/MidSideSpectrum.h"
+#include "dsp/AnalyzerDefs.h"
+#include "SharedSpectrum.h"
+#include "SpectrumTransport.h"
+#include "WorkerService.h"
 #include <SpinMutex.h>
-#include <RTSemaphore.h>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <memory>
+#include <chrono>
 
 class PluginSpectralAnalyzer : public Plugin {
 public:
@@ -42,7 +47,15 @@ public:
     // -------------------------------------------------------------------
 
     // Called by editor to indicate visibility status
-    void setEditorIsVisible(bool editorVisible) { fEditorVisible = editorVisible; }
+    // the work of the instance with a visible editor goes first
+    void setEditorIsVisible(bool editorVisible)
+    {
+        fEditorVisible = editorVisible;
+        WorkerService::setPriority(fWorkerTask, editorVisible ? WorkerService::kPriorityHigh : WorkerService::kPriorityNormal);
+    }
+
+    // Called by editor to indicate how often it picks up new frames
+    void setEditorRefreshInterval(double interval);
 
 protected:
     // -------------------------------------------------------------------
@@ -50,7 +63,7 @@ protected:
 
     const char *getLabel() const noexcept override
     {
-        return "Spectacle";
+        return SPECTACLE_PLUGIN_LABEL;
     }
 
     const char *getDescription() const override
@@ -85,7 +98,9 @@ protected:
     // Get a proper plugin UID and fill it in here!
     int64_t getUniqueId() const noexcept override
     {
-        return d_cconst('s', 'p', 'c', 't');
+        // the multichannel builds are told apart by their last letter
+        return (kNumChannels == 2) ? d_cconst('s', 'p', 'c', 't') :
+            d_cconst('s', 'p', 'c', 'A' + kNumChannels);
     }
 
     // -------------------------------------------------------------------
@@ -93,6 +108,7 @@ protected:
 
     void initParameter(uint32_t index, Parameter &parameter) override;
     void initProgramName(uint32_t index, String &programName) override;
+    void initState(uint32_t index, State &state) override;
 
     // -------------------------------------------------------------------
     // Internal data
@@ -100,6 +116,7 @@ protected:
     float getParameterValue(uint32_t index) const override;
     void setParameterValue(uint32_t index, float value) override;
     void loadProgram(uint32_t index) override;
+    void setState(const char *key, const char *value) override;
 
     // -------------------------------------------------------------------
     // Optional
@@ -116,15 +133,27 @@ protected:
     // -------------------------------------------------------------------
 
 private:
-    void runThread();
+    void runWorkerTask();
+    void reconfigure();
+    void processInLockstep(const float **inputs, uint32_t frames);
+    void encodeForRemoteEditor(const float *frequencies, const float *magnitudes, uint32_t numBins, uint32_t numCurves);
+    void sendFrameFragment();
+    void updateDspLoad(double elapsed, uint32_t frames);
+    uint32_t getAnalysisFrameInterval() const;
 
     // -------------------------------------------------------------------
 
 public:
     SpinMutex fSendMutex;
+    uint32_t fSendGeneration = 0; // incremented on every new analysis frame
     uint32_t fSendSize = 0;
+    uint32_t fSendNumCurves = 0;
+    ChannelMode fSendChannelMode = kChannelModeLeftRight; // tells what the curves are
     std::vector<float> fSendFrequencies;
-    std::vector<float> fSendMagnitudes;
+    std::vector<float> fSendMagnitudes; // values of the curves, of any kind
+
+    // the frames sent are also published for other processes, if enabled
+    SharedSpectrumWriter fShared;
 
     // -------------------------------------------------------------------
 
@@ -132,18 +161,66 @@ private:
     double fSampleRate = 44100;
 
     enum { kNumChannels = DISTRHO_PLUGIN_NUM_INPUTS };
+    enum { kMaxCurves = kNumChannels + 3 };
+
+    // the modes between channels need at least a pair
+    static_assert(kNumChannels >= 2 && kNumChannels <= 16, "the number of channels must be from 2 to 16");
 
     std::unique_ptr<BasicAnalyzer> fStft[kNumChannels];
     SpinMutex fStftMutex;
+    uint32_t fSentFrameCounter = ~0u;
+
+    // modes other than L/R: the channels are analyzed a step at a time, the
+    // new spectra of each step are accumulated into the cross-spectra, and
+    // those of each frame make the M/S spectra
+    ChannelMode fChannelMode = kChannelModeLeftRight;
+    CrossSpectrum fCrossSpectrum;
+    MidSideSpectrum fMidSide;
+    uint32_t fStepSize = 0;
+    uint32_t fStepPhase = 0;
+    uint32_t fSpectrumCounters[kNumChannels] = {};
+
+    // the frame interval given to the analyzers, and the steps counted the
+    // same way, to know which of them are frames
+    uint32_t fFrameInterval = 0;
+    uint32_t fFramePhase = 0;
+    uint32_t fPendingSteps = 0;
 
     std::atomic<bool> fMustReconfigureEnvelope { false };
+    std::atomic<bool> fMustReconfigureFrameInterval { false };
+    std::atomic<double> fEditorRefreshInterval { 0 }; // written by editor
+
+    // an editor without direct access gets the frames encoded as states, at
+    // most once per refresh; the audio thread encodes a frame, and the worker
+    // sends its fragments, each after the host passed the previous through
+    std::atomic<bool> fEditorIsRemote { false }; // written by editor
+    uint32_t fEditorSerial = 0; // of the last message of the editor
+    bool fEditorSerialValid = false;
+    std::atomic<bool> fEditorMessageReceived { false };
+    uint32_t fFramesSinceEditorMessage = 0;
+    std::atomic<bool> fMustSendKeyFrame { false };
+    SpectrumEncoder fEncoder;
+    uint32_t fFramesSinceEncoded = 0;
+    // the wrapper passes a state to the host after run(), in the same cycle;
+    // after a fragment is set, the next is set once a whole cycle has begun
+    // after it, so that the wrapper never reads the state while it's written
+    enum { kFrameIdle, kFrameReady, kFrameAwaitingCycle };
+    std::atomic<int> fFrameState { kFrameIdle };
+    uint32_t fFrameFragment = 0; // the next to send
+    uint32_t fFrameNumFragments = 0;
+    uint32_t fFrameCyclesWaited = 0;
 
     const std::unique_ptr<float[]> fParameters;
     const std::unique_ptr<ParameterRanges[]> fParameterRanges;
 
-    std::thread fThread;
-    RTSemaphore fThreadSem;
-    volatile bool fThreadQuit = false;
+    std::shared_ptr<WorkerService> fWorker;
+    WorkerService::Task *fWorkerTask = nullptr;
+    std::atomic<bool> fMustReconfigure { false };
+    std::atomic<bool> fMustPrecachePlans { false };
+
+    // fraction of the callback duration spent in it, averaged and peak
+    double fDspLoad = 0;
+    double fDspPeakLoad = 0;
 
     bool fComputationIsActive = false;
     bool fComputationStarts = false;
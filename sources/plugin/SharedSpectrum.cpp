@@ -0,0 +1,167 @@
+#include "SharedSpectrum.h"
+#include "DistrhoUtils.hpp"
+
+#if defined(ENABLE_SHARED_SPECTRUM)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+// the arrays start on a cache line
+static constexpr size_t kHeaderSize = (sizeof(SharedSpectrumHeader) + 63) & ~size_t(63);
+
+static std::atomic<unsigned> sInstanceCounter { 0 };
+
+static size_t getSegmentSize(uint32_t maxBins, uint32_t maxCurves)
+{
+    return kHeaderSize + size_t(1 + maxCurves) * maxBins * sizeof(float);
+}
+
+SharedSpectrumWriter::~SharedSpectrumWriter()
+{
+    close();
+}
+
+bool SharedSpectrumWriter::open(uint32_t numChannels, uint32_t maxBins, uint32_t maxCurves)
+{
+    close();
+
+    const char *prefix = std::getenv("SPECTACLE_SHM");
+    if (!prefix || !prefix[0])
+        return false;
+
+    const unsigned instance = ++sInstanceCounter;
+    std::snprintf(fName, sizeof(fName), "/%s-%ld-%u", prefix, (long)getpid(), instance);
+
+    fFd = shm_open(fName, O_RDWR|O_CREAT|O_EXCL, 0644);
+    if (fFd == -1) {
+        d_stderr("Cannot create the shared memory %s: %s", fName, std::strerror(errno));
+        fName[0] = '\0';
+        return false;
+    }
+
+    if (!map(getSegmentSize(maxBins, maxCurves))) {
+        close();
+        return false;
+    }
+
+    SharedSpectrumHeader *header = new (fHeader) SharedSpectrumHeader;
+    std::memcpy(header->magic, kSharedSpectrumMagic, sizeof(header->magic));
+    header->version = kSharedSpectrumVersion;
+    header->headerSize = kHeaderSize;
+    header->segmentSize = fMappedSize;
+    header->pid = (int32_t)getpid();
+    header->numChannels = numChannels;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->generation = 0;
+    header->sampleRate = 0;
+    header->numBins = 0;
+    header->numCurves = 0;
+    header->channelMode = 0;
+    header->reserved = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return true;
+}
+
+void SharedSpectrumWriter::close()
+{
+    if (fHeader) {
+        munmap(fHeader, fMappedSize);
+        fHeader = nullptr;
+        fMappedSize = 0;
+    }
+    if (fFd != -1) {
+        ::close(fFd);
+        fFd = -1;
+    }
+    if (fName[0]) {
+        shm_unlink(fName);
+        fName[0] = '\0';
+    }
+}
+
+bool SharedSpectrumWriter::reserve(uint32_t maxBins, uint32_t maxCurves)
+{
+    SharedSpectrumHeader *header = fHeader;
+    if (!header)
+        return false;
+
+    const size_t size = getSegmentSize(maxBins, maxCurves);
+    if (size <= fMappedSize)
+        return true;
+
+    // the readers see the new size in the header, and map again
+    const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (!map(size)) {
+        close();
+        return false;
+    }
+
+    header = fHeader;
+    header->segmentSize = fMappedSize;
+    header->sequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
+
+bool SharedSpectrumWriter::map(size_t size)
+{
+    const size_t oldSize = fMappedSize;
+
+    if (ftruncate(fFd, (off_t)size) == -1) {
+        d_stderr("Cannot resize the shared memory %s: %s", fName, std::strerror(errno));
+        return false;
+    }
+
+    void *address = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fFd, 0);
+    if (address == MAP_FAILED) {
+        d_stderr("Cannot map the shared memory %s: %s", fName, std::strerror(errno));
+        return false;
+    }
+
+    // fault in the pages now, rather than in the audio thread
+    std::memset((char *)address + oldSize, 0, size - oldSize);
+
+    if (fHeader)
+        munmap(fHeader, oldSize);
+    fHeader = (SharedSpectrumHeader *)address;
+    fMappedSize = size;
+    return true;
+}
+
+void SharedSpectrumWriter::publish(double sampleRate, uint32_t channelMode, uint32_t numBins, uint32_t numCurves, const float *frequencies, const float *magnitudes)
+{
+    SharedSpectrumHeader *header = fHeader;
+    if (!header)
+        return;
+
+    // a frame larger than the segment waits for the next reserve
+    if (getSegmentSize(numBins, numCurves) > fMappedSize)
+        return;
+
+    const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ++header->generation;
+    header->sampleRate = sampleRate;
+    header->numBins = numBins;
+    header->numCurves = numCurves;
+    header->channelMode = channelMode;
+
+    float *data = (float *)((char *)header + kHeaderSize);
+    std::memcpy(data, frequencies, numBins * sizeof(float));
+    std::memcpy(data + numBins, magnitudes, size_t(numCurves) * numBins * sizeof(float));
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+// Publication of the analysis frames into POSIX shared memory, for other local
+// processes to read without going through the display.
+//
+// It is compiled in with ENABLE_SHARED_SPECTRUM, and it publishes only when
+// the variable SPECTACLE_SHM gives a prefix to name the segments. Each plugin
+// instance creates its own, named "/<prefix>-<pid>-<instance>", which appears
+// on Linux under /dev/shm, and removes it when it's destroyed.
+//
+// The segment starts with the header below, followed by `headerSize` bytes by
+// the frequency axis, `numBins` floats, then by the curves, `numCurves` times
+// `numBins` floats; the curves are in the order and of the kinds given by the
+// channel mode, as told by `getCurveKind` and `getCurveSignal`.
+//
+// The writer never waits on the readers. It updates the frame under a seqlock,
+// where `sequence` is odd while a frame is being written; a reader copies
+// what it needs between two loads of the sequence, and retries if they are
+// not the same even number:
+//
+//     s1 = sequence.load(acquire)
+//     copy the header fields and the arrays
+//     atomic_thread_fence(acquire)
+//     s2 = sequence.load(relaxed)
+//     valid if s1 == s2 and s1 is even
+//
+// The segment grows when the analysis needs more bins than it holds; a reader
+// whose mapping is shorter than `segmentSize` maps the segment again.
+//------------------------------------------------------------------------------
+
+struct SharedSpectrumHeader {
+    char magic[8]; // "SPECTCL"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t segmentSize;
+    int32_t pid; // of the writer, to tell leftovers of a process which died
+    uint32_t numChannels;
+
+    std::atomic<uint32_t> sequence;
+    uint32_t generation; // incremented on every new frame
+    double sampleRate;
+    uint32_t numBins;
+    uint32_t numCurves;
+    uint32_t channelMode;
+    uint32_t reserved;
+};
+
+static constexpr char kSharedSpectrumMagic[8] = "SPECTCL";
+static constexpr uint32_t kSharedSpectrumVersion = 1;
+
+#if defined(ENABLE_SHARED_SPECTRUM)
+
+class SharedSpectrumWriter {
+public:
+    SharedSpectrumWriter() = default;
+    ~SharedSpectrumWriter();
+
+    // creates the segment if SPECTACLE_SHM is set; not realtime-safe
+    bool open(uint32_t numChannels, uint32_t maxBins, uint32_t maxCurves);
+    void close();
+    bool isOpen() const { return fHeader != nullptr; }
+
+    // grows the segment to hold a frame of this size, touching all its pages
+    // so that publishing does not fault; not realtime-safe
+    bool reserve(uint32_t maxBins, uint32_t maxCurves);
+
+    // writes a frame; realtime-safe, it does not wait on the readers
+    void publish(double sampleRate, uint32_t channelMode, uint32_t numBins, uint32_t numCurves, const float *frequencies, const float *magnitudes);
+
+private:
+    bool map(size_t size);
+
+private:
+    int fFd = -1;
+    char fName[256] = {};
+    SharedSpectrumHeader *fHeader = nullptr;
+    size_t fMappedSize = 0;
+
+    SharedSpectrumWriter(const SharedSpectrumWriter &) = delete;
+    SharedSpectrumWriter &operator=(const SharedSpectrumWriter &) = delete;
+};
+
+#else
+
+class SharedSpectrumWriter {
+public:
+    bool open(uint32_t, uint32_t, uint32_t) { return false; }
+    void close() {}
+    bool isOpen() const { return false; }
+    bool reserve(uint32_t, uint32_t) { return false; }
+    void publish(double, uint32_t, uint32_t, uint32_t, const float *, const float *) {}
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "SpectrumTransport.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+
+static constexpr uint8_t kFrameVersion = 1;
+static constexpr uint8_t kFrameIsKey = 1;
+
+// a key frame at least this often, for an editor which missed a frame
+static constexpr uint32_t kKeyFrameInterval = 32;
+
+// the quantized values are bounded, so their differences fit 4 bytes
+static constexpr float kMaxQuantized = (float)(1 << 20);
+
+static constexpr char kBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int getBase64Digit(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+    return -1;
+}
+
+static float getQuantizationStep(CurveKind kind)
+{
+    switch (kind) {
+    case kCurveCoherence:
+        return 1.0f / 4096;
+    default:
+        return 1.0f / 16;
+    }
+}
+
+static int32_t quantize(float value, float step)
+{
+    float q = value / step;
+    if (!(q > -kMaxQuantized))
+        q = -kMaxQuantized;
+    else if (q > kMaxQuantized)
+        q = kMaxQuantized;
+    return (int32_t)std::lrint(q);
+}
+
+static uint8_t *putVarint(uint8_t *p, uint32_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &value)
+{
+    value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+        if (p == end)
+            return false;
+        const uint8_t byte = *p++;
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static void putFloat(uint8_t *p, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    for (uint32_t i = 0; i < 4; ++i)
+        p[i] = (uint8_t)(bits >> (8 * i));
+}
+
+static float getFloat(const uint8_t *p)
+{
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < 4; ++i)
+        bits |= (uint32_t)p[i] << (8 * i);
+    float value;
+    std::memcpy(&value, &bits, 4);
+    return value;
+}
+
+///
+void SpectrumEncoder::configure(uint32_t numChannels, uint32_t maxBins, uint32_t maxCurves)
+{
+    fNumChannels = numChannels;
+    fMaxBins = maxBins;
+    fMaxCurves = maxCurves;
+
+    fPrevious.resize(maxCurves * maxBins);
+
+    // header, key frequencies, and values of at most 4 bytes each
+    const size_t maxBytes = 4 + 2 * 5 + 4 * maxBins + 4 * maxCurves * maxBins;
+    fBytes.resize(maxBytes);
+    fText.resize(4 * ((maxBytes + 2) / 3) + 1);
+    fTextSize = 0;
+    fMessage.resize(2 * 11 + kFrameFragmentSize + 1);
+
+    fMustSendKeyFrame = true;
+}
+
+const char *SpectrumEncoder::encode(ChannelMode channelMode, uint32_t numBins, uint32_t numCurves, const float *frequencies, const float *magnitudes)
+{
+    if (numBins > fMaxBins || numCurves > fMaxCurves)
+        return nullptr;
+
+    const bool isKey = fMustSendKeyFrame || fFramesSinceKey + 1 >= kKeyFrameInterval ||
+        channelMode != fPreviousMode || numBins != fPreviousBins || numCurves != fPreviousCurves;
+
+    uint8_t *p = fBytes.data();
+    *p++ = kFrameVersion;
+    *p++ = isKey ? kFrameIsKey : 0;
+    *p++ = (uint8_t)channelMode;
+    *p++ = (uint8_t)numCurves;
+    p = putVarint(p, numBins);
+    p = putVarint(p, ++fSequence);
+
+    if (isKey) {
+        for (uint32_t i = 0; i < numBins; ++i, p += 4)
+            putFloat(p, frequencies[i]);
+        std::fill_n(fPrevious.begin(), numCurves * numBins, 0);
+    }
+
+    for (uint32_t c = 0; c < numCurves; ++c) {
+        const float step = getQuantizationStep(getCurveKind(channelMode, fNumChannels, c));
+        const float *values = &magnitudes[c * numBins];
+        int32_t *previous = &fPrevious[c * numBins];
+        for (uint32_t i = 0; i < numBins; ++i) {
+            const int32_t q = quantize(values[i], step);
+            p = putVarint(p, zigzag(q - previous[i]));
+            previous[i] = q;
+        }
+    }
+
+    fPreviousMode = channelMode;
+    fPreviousBins = numBins;
+    fPreviousCurves = numCurves;
+    fFramesSinceKey = isKey ? 0 : (fFramesSinceKey + 1);
+    fMustSendKeyFrame = false;
+
+    // base64, with padding
+    const uint8_t *bytes = fBytes.data();
+    const size_t numBytes = p - bytes;
+    char *text = fText.data();
+    size_t i = 0;
+    for (; i + 3 <= numBytes; i += 3) {
+        const uint32_t v = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+        *text++ = kBase64Alphabet[(v >> 18) & 63];
+        *text++ = kBase64Alphabet[(v >> 12) & 63];
+        *text++ = kBase64Alphabet[(v >> 6) & 63];
+        *text++ = kBase64Alphabet[v & 63];
+    }
+    if (i < numBytes) {
+        const bool two = i + 1 < numBytes;
+        const uint32_t v = (bytes[i] << 16) | (two ? (bytes[i + 1] << 8) : 0);
+        *text++ = kBase64Alphabet[(v >> 18) & 63];
+        *text++ = kBase64Alphabet[(v >> 12) & 63];
+        *text++ = two ? kBase64Alphabet[(v >> 6) & 63] : '=';
+        *text++ = '=';
+    }
+    *text = '\0';
+    fTextSize = text - fText.data();
+
+    return fText.data();
+}
+
+uint32_t SpectrumEncoder::getNumFragments() const
+{
+    return (uint32_t)((fTextSize + kFrameFragmentSize - 1) / kFrameFragmentSize);
+}
+
+const char *SpectrumEncoder::getFragment(uint32_t index)
+{
+    const size_t start = std::min(fTextSize, (size_t)index * kFrameFragmentSize);
+    const size_t length = std::min(fTextSize - start, (size_t)kFrameFragmentSize);
+
+    char *message = fMessage.data();
+    const int prefix = std::sprintf(message, "%u %u ", index, getNumFragments());
+    std::memcpy(message + prefix, &fText[start], length);
+    message[prefix + length] = '\0';
+
+    return message;
+}
+
+///
+bool SpectrumDecoder::receive(const char *message)
+{
+    unsigned index;
+    unsigned count;
+    int prefix;
+    if (std::sscanf(message, "%u %u %n", &index, &count, &prefix) != 2 || index >= count)
+        return false;
+
+    // a fragment out of order loses the frame, and the next ones until a
+    // key frame, which the decoder waits for
+    if (index == 0)
+        fText.clear();
+    else if (index != fNextFragment) {
+        fNextFragment = 0;
+        return false;
+    }
+
+    fText.append(message + prefix);
+    fNextFragment = index + 1;
+    if (fNextFragment < count)
+        return false;
+
+    fNextFragment = 0;
+    return decode(fText.c_str());
+}
+
+bool SpectrumDecoder::decode(const char *text)
+{
+    // base64, stopping at the padding
+    fBytes.clear();
+    uint32_t bits = 0;
+    uint32_t numBits = 0;
+    for (const char *s = text; *s && *s != '='; ++s) {
+        const int d = getBase64Digit(*s);
+        if (d < 0)
+            return false;
+        bits = (bits << 6) | d;
+        numBits += 6;
+        if (numBits >= 8) {
+            numBits -= 8;
+            fBytes.push_back((uint8_t)(bits >> numBits));
+        }
+    }
+
+    const uint8_t *p = fBytes.data();
+    const uint8_t *end = p + fBytes.size();
+    if (end - p < 4 || p[0] != kFrameVersion)
+        return false;
+
+    const bool isKey = p[1] & kFrameIsKey;
+    const ChannelMode channelMode = (ChannelMode)p[2];
+    const uint32_t numCurves = p[3];
+    p += 4;
+
+    uint32_t numBins;
+    uint32_t sequence;
+    if (!getVarint(p, end, numBins) || !getVarint(p, end, sequence))
+        return false;
+    if (channelMode >= kNumChannelModes || numCurves != ::getNumCurves(channelMode, fNumChannels))
+        return false;
+
+    if (isKey) {
+        if ((size_t)(end - p) < 4 * (size_t)numBins)
+            return false;
+        fFrequencies.resize(numBins);
+        for (uint32_t i = 0; i < numBins; ++i, p += 4)
+            fFrequencies[i] = getFloat(p);
+        fQuantized.assign(numCurves * numBins, 0);
+        fChannelMode = channelMode;
+        fNumBins = numBins;
+        fNumCurves = numCurves;
+        fSynchronized = true;
+    }
+    else if (!fSynchronized || sequence != fSequence + 1 || channelMode != fChannelMode ||
+             numBins != fNumBins || numCurves != fNumCurves) {
+        fSynchronized = false;
+        return false;
+    }
+
+    fMagnitudes.resize(numCurves * numBins);
+    for (uint32_t c = 0; c < numCurves; ++c) {
+        const float step = getQuantizationStep(getCurveKind(channelMode, fNumChannels, c));
+        int32_t *quantized = &fQuantized[c * numBins];
+        float *values = &fMagnitudes[c * numBins];
+        for (uint32_t i = 0; i < numBins; ++i) {
+            uint32_t delta;
+            if (!getVarint(p, end, delta)) {
+                fSynchronized = false;
+                return false;
+            }
+            quantized[i] += unzigzag(delta);
+            values[i] = quantized[i] * step;
+        }
+    }
+
+    fSequence = sequence;
+    return true;
+}
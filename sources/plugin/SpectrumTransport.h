@@ -0,0 +1,105 @@
+#pragma once
+#include "dsp/AnalyzerDefs.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+// Compact encoding of the analysis frames, for an editor which runs in another
+// process and receives them as state messages, instead of reading them from
+// the plugin instance.
+//
+// The values are quantized to steps finer than the display can show, by the
+// kind of curve: 1/16 dB for the magnitudes and gains, 1/16 degree for the
+// phase, 1/4096 for the coherence. A frame carries the differences to the one
+// before, as variable-length integers; being small where the spectrum is
+// steady, they take mostly one byte. A key frame carries the differences to
+// zero, and the frequency axis; it's sent whenever the geometry changes, at
+// regular intervals, and on request. The bytes are text-encoded in base64.
+//
+// The host passes the states through a port of limited size, so the text is
+// sent in fragments of at most kFrameFragmentSize characters, as messages
+// "<index> <count> <text>". The receiver joins them, and drops the frames of
+// which it missed a fragment.
+//
+// Layout of a frame, before base64:
+//     u8 version, u8 flags (1 = key frame), u8 channel mode, u8 curve count,
+//     varint bin count, varint sequence number,
+//     [key frame] bin count times f32 frequency, little-endian,
+//     curve count times bin count times zigzag varint difference
+//------------------------------------------------------------------------------
+
+static constexpr uint32_t kFrameFragmentSize = 32768;
+
+class SpectrumEncoder {
+public:
+    // allocates for the largest frame; not realtime-safe
+    void configure(uint32_t numChannels, uint32_t maxBins, uint32_t maxCurves);
+
+    // makes the next frame a key frame
+    void requestKeyFrame() { fMustSendKeyFrame = true; }
+
+    // encodes a frame into text which stays valid until the next call, or
+    // returns null if the frame is larger than configured; realtime-safe
+    const char *encode(ChannelMode channelMode, uint32_t numBins, uint32_t numCurves, const float *frequencies, const float *magnitudes);
+
+    // the messages of the last frame encoded, valid until the next call
+    uint32_t getNumFragments() const;
+    const char *getFragment(uint32_t index);
+
+private:
+    uint32_t fNumChannels = 0;
+    uint32_t fMaxBins = 0;
+    uint32_t fMaxCurves = 0;
+
+    // the last frame, as quantized
+    std::vector<int32_t> fPrevious;
+    ChannelMode fPreviousMode = kChannelModeLeftRight;
+    uint32_t fPreviousBins = 0;
+    uint32_t fPreviousCurves = 0;
+    uint32_t fSequence = 0;
+    uint32_t fFramesSinceKey = 0;
+    bool fMustSendKeyFrame = true;
+
+    std::vector<uint8_t> fBytes;
+    std::vector<char> fText;
+    size_t fTextSize = 0;
+    std::vector<char> fMessage;
+};
+
+class SpectrumDecoder {
+public:
+    explicit SpectrumDecoder(uint32_t numChannels) : fNumChannels(numChannels) {}
+
+    // decodes a frame; false if it's invalid, or is the difference to a frame
+    // which was missed, in which case it waits for the next key frame
+    bool decode(const char *text);
+
+    // joins a fragment to those received before; true if it completes a
+    // frame which decodes
+    bool receive(const char *message);
+
+    ChannelMode getChannelMode() const { return fChannelMode; }
+    uint32_t getNumBins() const { return fNumBins; }
+    uint32_t getNumCurves() const { return fNumCurves; }
+    const float *getFrequencies() const { return fFrequencies.data(); }
+    const float *getMagnitudes() const { return fMagnitudes.data(); }
+
+private:
+    uint32_t fNumChannels = 0;
+
+    ChannelMode fChannelMode = kChannelModeLeftRight;
+    uint32_t fNumBins = 0;
+    uint32_t fNumCurves = 0;
+    uint32_t fSequence = 0;
+    bool fSynchronized = false;
+
+    std::vector<int32_t> fQuantized;
+    std::vector<float> fFrequencies;
+    std::vector<float> fMagnitudes;
+    std::vector<uint8_t> fBytes;
+
+    // the fragments joined so far, and the index of the next
+    std::string fText;
+    uint32_t fNextFragment = 0;
+};
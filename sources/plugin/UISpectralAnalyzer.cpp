@@ -38,15 +38,22 @@
 #include "ui/FontEngine.h"
 #include "dsp/AnalyzerDefs.h"
 #include "util/format_string.h"
+#include "util/trace_events.h"
+#include "dsp/BandAggregator.h"
 #include "Window.hpp"
 #include "Color.hpp"
 #include <sys/stat.h>
+#include <algorithm>
+#include <random>
+#include <cstring>
+#include <cstdio>
 #include <cmath>
 
 enum {
     kToolBarIdSetup = 1,
     kToolBarIdScale,
     kToolBarIdFreeze,
+    kToolBarIdSpectrogram,
     kToolBarIdSelect,
     kToolBarIdHide,
     kToolBarIdColor,
@@ -59,6 +66,8 @@ UISpectralAnalyzer::UISpectralAnalyzer()
     : UI(1000, 350),
       fPalette(new ColorPalette(ColorPalette::create_default()))
 {
+    trace_init();
+
     ColorPalette &palette = *fPalette;
 
     {
@@ -85,6 +94,22 @@ UISpectralAnalyzer::UISpectralAnalyzer()
         uiConfig.SetValue("ui", "theme", "default", "; Identifier of the theme which is active on program startup");
         updateUiConfig = true;
     }
+    if (!uiConfig.GetValue("ui", "renderer")) {
+        uiConfig.SetValue("ui", "renderer", "nanovg", "; Method of drawing the spectrum curves: nanovg, opengl");
+        updateUiConfig = true;
+    }
+    if (!uiConfig.GetValue("ui", "interpolation")) {
+        uiConfig.SetValue("ui", "interpolation", "true", "; Whether to interpolate the display between analysis frames: true, false");
+        updateUiConfig = true;
+    }
+    if (!uiConfig.GetValue("ui", "load_meter")) {
+        uiConfig.SetValue("ui", "load_meter", "false", "; Whether to show the DSP load over the spectrum: true, false");
+        updateUiConfig = true;
+    }
+    if (!uiConfig.GetValue("ui", "bands")) {
+        uiConfig.SetValue("ui", "bands", "0", "; Number of display bands per octave: 0 (continuous), 1, 3, 6, 12");
+        updateUiConfig = true;
+    }
     if (updateUiConfig)
         save_configuration("ui", uiConfig);
 
@@ -93,11 +118,21 @@ UISpectralAnalyzer::UISpectralAnalyzer()
     FontEngine fe(*this, palette);
 
     fSpectrumView = makeSubwidget<SpectrumView>(this, palette);
+    if (!std::strcmp(uiConfig.GetValue("ui", "renderer", "nanovg"), "opengl"))
+        fSpectrumView->setRenderer(SpectrumView::kRendererOpenGL);
+    fSpectrumView->setInterpolation(uiConfig.GetBoolValue("ui", "interpolation", true));
+    fSpectrumView->setShowDspLoad(uiConfig.GetBoolValue("ui", "load_meter", false));
+    switch (uiConfig.GetLongValue("ui", "bands", 0)) {
+    case 1: case 3: case 6: case 12:
+        fSpectrumView->setBandsPerOctave(uiConfig.GetLongValue("ui", "bands", 0));
+        break;
+    }
 
     fMainToolBar = makeSubwidget<MainToolBar>(this, palette);
     fMainToolBar->addButton(kToolBarIdSetup, "Setup", "\uf085");
     fMainToolBar->addButton(kToolBarIdScale, "Scale", "\uf0b2");
     fMainToolBar->addButton(kToolBarIdFreeze, "Freeze", "\uf256");
+    fMainToolBar->addButton(kToolBarIdSpectrogram, "History", "\uf00a");
     fMainToolBar->addButton(kToolBarIdSelect, "Select", "\uf05b");
     fMainToolBar->addButton(kToolBarIdHide, "Hide", "\uf0d0");
     fMainToolBar->addButton(kToolBarIdColor, "Color", "\uf53f");
@@ -122,7 +157,7 @@ UISpectralAnalyzer::UISpectralAnalyzer()
 
     fSetupWindow = makeSubwidget<FloatingWindow>(this, palette);
     fSetupWindow->setVisible(false);
-    fSetupWindow->setSize(260, 160);
+    fSetupWindow->setSize(260, 310);
     {
         int y = 10;
 
@@ -148,6 +183,25 @@ UISpectralAnalyzer::UISpectralAnalyzer()
 
         y += 30;
 
+        label = makeSubwidget<TextLabel>(fSetupWindow, palette);
+        label->setText("Channels");
+        label->setFont(fontLabel);
+        label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
+        label->setAbsolutePos(10, y);
+        label->setSize(100, 20);
+        fSetupWindow->moveAlong(label);
+
+        fChannelModeChooser = makeSubwidget<SpinBoxChooser>(fSetupWindow, palette);
+        fChannelModeChooser->setSize(150, 20);
+        fChannelModeChooser->setAbsolutePos(100, y);
+        for (uint32_t mode = 0; mode < kNumChannelModes; ++mode)
+            fChannelModeChooser->addChoice(mode, getChannelModeName((ChannelMode)mode));
+        fChannelModeChooser->ValueChangedCallback = [this](int32_t value)
+            { setParameterValue(kPidChannelMode, value); };
+        fSetupWindow->moveAlong(fChannelModeChooser);
+
+        y += 30;
+
         label = makeSubwidget<TextLabel>(fSetupWindow, palette);
         label->setText("Resolution");
         label->setFont(fontLabel);
@@ -223,6 +277,102 @@ UISpectralAnalyzer::UISpectralAnalyzer()
         fReleaseTimeSlider->FormatCallback = [](double value) -> std::string
             { return std::to_string(std::lround(value * 1e3)) + " ms"; };
         fSetupWindow->moveAlong(fReleaseTimeSlider);
+
+        y += 30;
+
+        label = makeSubwidget<TextLabel>(fSetupWindow, palette);
+        label->setText("Renderer");
+        label->setFont(fontLabel);
+        label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
+        label->setAbsolutePos(10, y);
+        label->setSize(100, 20);
+        fSetupWindow->moveAlong(label);
+
+        fRendererChooser = makeSubwidget<SpinBoxChooser>(fSetupWindow, palette);
+        fRendererChooser->setSize(150, 20);
+        fRendererChooser->setAbsolutePos(100, y);
+        for (int renderer = 0; renderer < SpectrumView::kNumRenderers; ++renderer)
+            fRendererChooser->addChoice(renderer, SpectrumView::getRendererName(renderer));
+        fRendererChooser->setValue(fSpectrumView->renderer());
+        fRendererChooser->ValueChangedCallback = [this](int32_t value) {
+            fSpectrumView->setRenderer(value);
+            fUiConfig->SetValue("ui", "renderer", (value == SpectrumView::kRendererOpenGL) ? "opengl" : "nanovg", nullptr, true);
+            save_configuration("ui", *fUiConfig);
+        };
+        fSetupWindow->moveAlong(fRendererChooser);
+
+        y += 30;
+
+        label = makeSubwidget<TextLabel>(fSetupWindow, palette);
+        label->setText("Interpolation");
+        label->setFont(fontLabel);
+        label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
+        label->setAbsolutePos(10, y);
+        label->setSize(100, 20);
+        fSetupWindow->moveAlong(label);
+
+        fInterpolationChooser = makeSubwidget<SpinBoxChooser>(fSetupWindow, palette);
+        fInterpolationChooser->setSize(150, 20);
+        fInterpolationChooser->setAbsolutePos(100, y);
+        fInterpolationChooser->addChoice(0, "Off");
+        fInterpolationChooser->addChoice(1, "On");
+        fInterpolationChooser->setValue(fSpectrumView->interpolation());
+        fInterpolationChooser->ValueChangedCallback = [this](int32_t value) {
+            fSpectrumView->setInterpolation(value != 0);
+            fUiConfig->SetBoolValue("ui", "interpolation", value != 0, nullptr, true);
+            save_configuration("ui", *fUiConfig);
+        };
+        fSetupWindow->moveAlong(fInterpolationChooser);
+
+        y += 30;
+
+        label = makeSubwidget<TextLabel>(fSetupWindow, palette);
+        label->setText("Load meter");
+        label->setFont(fontLabel);
+        label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
+        label->setAbsolutePos(10, y);
+        label->setSize(100, 20);
+        fSetupWindow->moveAlong(label);
+
+        fLoadMeterChooser = makeSubwidget<SpinBoxChooser>(fSetupWindow, palette);
+        fLoadMeterChooser->setSize(150, 20);
+        fLoadMeterChooser->setAbsolutePos(100, y);
+        fLoadMeterChooser->addChoice(0, "Off");
+        fLoadMeterChooser->addChoice(1, "On");
+        fLoadMeterChooser->setValue(fSpectrumView->showDspLoad());
+        fLoadMeterChooser->ValueChangedCallback = [this](int32_t value) {
+            fSpectrumView->setShowDspLoad(value != 0);
+            fUiConfig->SetBoolValue("ui", "load_meter", value != 0, nullptr, true);
+            save_configuration("ui", *fUiConfig);
+        };
+        fSetupWindow->moveAlong(fLoadMeterChooser);
+
+        y += 30;
+
+        label = makeSubwidget<TextLabel>(fSetupWindow, palette);
+        label->setText("Display");
+        label->setFont(fontLabel);
+        label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
+        label->setAbsolutePos(10, y);
+        label->setSize(100, 20);
+        fSetupWindow->moveAlong(label);
+
+        fDisplayChooser = makeSubwidget<SpinBoxChooser>(fSetupWindow, palette);
+        fDisplayChooser->setSize(150, 20);
+        fDisplayChooser->setAbsolutePos(100, y);
+        fDisplayChooser->addChoice(0, "Spectrum");
+        fDisplayChooser->addChoice(1, "1/1 octave");
+        fDisplayChooser->addChoice(3, "1/3 octave");
+        fDisplayChooser->addChoice(6, "1/6 octave");
+        fDisplayChooser->addChoice(12, "1/12 octave");
+        fDisplayChooser->setValue(fSpectrumView->bandsPerOctave());
+        fDisplayChooser->ValueChangedCallback = [this](int32_t value) {
+            fSpectrumView->setBandsPerOctave(value);
+            fUiConfig->SetLongValue("ui", "bands", value, nullptr, false, true);
+            save_configuration("ui", *fUiConfig);
+            displaySpectrum();
+        };
+        fSetupWindow->moveAlong(fDisplayChooser);
     }
 
     fScaleWindow = makeSubwidget<FloatingWindow>(this, palette);
@@ -270,7 +420,7 @@ UISpectralAnalyzer::UISpectralAnalyzer()
 
     fSelectWindow = makeSubwidget<FloatingWindow>(this, palette);
     fSelectWindow->setVisible(false);
-    fSelectWindow->setSize(420, 100);
+    fSelectWindow->setSize(460, std::max(100, 40 + 30 * (int)kNumChannels));
     {
         int x = 0;
         int y = 10;
@@ -350,19 +500,16 @@ UISpectralAnalyzer::UISpectralAnalyzer()
         y = 10;
         x += 120;
 
-        for (unsigned c = 0; c < kNumChannels; ++c) {
-            y = 10;
-
-            if (c == 0) {
-                label = makeSubwidget<TextLabel>(fSelectWindow, palette);
-                label->setText("Nearby peak");
-                label->setFont(fontLabel);
-                label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
-                label->setAbsolutePos(x + 10, y);
-                label->setSize(100, 20);
-                fSelectWindow->moveAlong(label);
-            }
+        label = makeSubwidget<TextLabel>(fSelectWindow, palette);
+        label->setText("Nearby peak");
+        label->setFont(fontLabel);
+        label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
+        label->setAbsolutePos(x + 10, y);
+        label->setSize(100, 20);
+        fSelectWindow->moveAlong(label);
 
+        // a row per channel, next to the value under the cursor
+        for (unsigned c = 0; c < kNumChannels; ++c) {
             y += 30;
 
             label = makeSubwidget<TextLabel>(fSelectWindow, palette);
@@ -382,26 +529,14 @@ UISpectralAnalyzer::UISpectralAnalyzer()
             label->setSize(100, 20);
             fSelectWindow->moveAlong(label);
 
-            y += 30;
-
-            label = makeSubwidget<TextLabel>(fSelectWindow, palette);
-            label->setText("\uf140");
-            label->setFont(fontChNAwesome[c]);
-            label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
-            label->setAbsolutePos(x + 10, y);
-            label->setSize(100, 20);
-            fSelectWindow->moveAlong(label);
-
             label = makeSubwidget<TextLabel>(fSelectWindow, palette);
             fSelectNearPeakY[c] = label;
             //label->setText("");
             label->setFont(fontChNLabel[c]);
             label->setAlignment(kAlignLeft|kAlignCenter|kAlignInside);
-            label->setAbsolutePos(x + 30, y);
+            label->setAbsolutePos(x + 130, y);
             label->setSize(100, 20);
             fSelectWindow->moveAlong(label);
-
-            x += 100;
         }
     }
 
@@ -458,7 +593,9 @@ UISpectralAnalyzer::UISpectralAnalyzer()
 
 UISpectralAnalyzer::~UISpectralAnalyzer()
 {
-    getPluginInstance()->setEditorIsVisible(false);
+    reportEditorVisible(false);
+
+    trace_shutdown();
 }
 
 PluginSpectralAnalyzer *UISpectralAnalyzer::getPluginInstance()
@@ -491,9 +628,28 @@ void UISpectralAnalyzer::parameterChanged(uint32_t index, float value)
     case kPidAlgorithm:
         fAlgorithmChooser->setValue(value);
         break;
+    case kPidChannelMode:
+        fChannelModeChooser->setValue(value);
+        break;
+    case kPidDspLoad:
+        fSpectrumView->setDspLoad(value);
+        break;
+    case kPidDspPeakLoad:
+        fSpectrumView->setDspPeakLoad(value);
+        break;
     }
 }
 
+/**
+  A state has changed on the plugin side.
+  This is called by the host to inform the UI about state changes.
+*/
+void UISpectralAnalyzer::stateChanged(const char *key, const char *value)
+{
+    if (std::strcmp(key, "frame") == 0 && fDecoder.receive(value))
+        receiveFrame();
+}
+
 /**
   A program has been loaded on the plugin side.
   This is called by the host to inform the UI about program changes.
@@ -521,9 +677,16 @@ void UISpectralAnalyzer::sampleRateChanged(double newSampleRate)
 */
 void UISpectralAnalyzer::uiIdle()
 {
-    getPluginInstance()->setEditorIsVisible(isVisible());
+    TRACE_THREAD_NAME("ui");
+
+    reportEditorVisible(isVisible());
+    if (fReportedVisible && !getPluginInstance() &&
+        std::chrono::steady_clock::now() - fEditorStateTime > std::chrono::duration<double>(kEditorStateInterval))
+        sendEditorState();
 
+    updateRefreshInterval();
     updateSpectrum();
+    fSpectrumView->animate();
 
     // under theme developer mode, recheck periodically for edits
     if (fThemeEditChooser->value()) {
@@ -671,6 +834,13 @@ void UISpectralAnalyzer::onToolBarItemClicked(int id)
     case kToolBarIdFreeze:
         fSpectrumView->toggleFreeze();
         fMainToolBar->setSelected(kToolBarIdFreeze, fSpectrumView->isFrozen());
+        // the plugin's generation only grows, so this takes its next frame
+        if (!fSpectrumView->isFrozen())
+            --fGeneration;
+        break;
+    case kToolBarIdSpectrogram:
+        fSpectrumView->toggleSpectrogram();
+        fMainToolBar->setSelected(kToolBarIdSpectrogram, fSpectrumView->isSpectrogram());
         break;
     case kToolBarIdSelect:
         switchMode((fMode == kModeSelect) ? kModeNormal : kModeSelect);
@@ -758,18 +928,202 @@ void UISpectralAnalyzer::setNewSelectionPositionByMouse(DGL::Point<int> pos)
     updateSelectModeDisplays();
 }
 
+void UISpectralAnalyzer::updateRefreshInterval()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double interval = std::chrono::duration<double>(now - fIdleTime).count();
+    fIdleTime = now;
+
+    // a long pause is not the refresh rate, eg. the window was hidden
+    if (interval > kMaxRefreshInterval)
+        return;
+
+    const double clampedInterval = std::max(kMinRefreshInterval, interval);
+    if (fRefreshInterval == 0)
+        fRefreshInterval = clampedInterval;
+    else
+        fRefreshInterval += 0.1 * (clampedInterval - fRefreshInterval);
+
+    // let the DSP know when it changes noticeably
+    if (std::fabs(fRefreshInterval - fReportedRefreshInterval) > 0.1 * fReportedRefreshInterval) {
+        reportRefreshInterval(fRefreshInterval);
+    }
+}
+
+void UISpectralAnalyzer::reportEditorVisible(bool visible)
+{
+    if (PluginSpectralAnalyzer *plugin = getPluginInstance())
+        plugin->setEditorIsVisible(visible);
+    else if (visible != fReportedVisible) {
+        fReportedVisible = visible;
+        sendEditorState();
+    }
+}
+
+void UISpectralAnalyzer::reportRefreshInterval(double interval)
+{
+    fReportedRefreshInterval = interval;
+    if (PluginSpectralAnalyzer *plugin = getPluginInstance())
+        plugin->setEditorRefreshInterval(interval);
+    else
+        sendEditorState();
+}
+
+void UISpectralAnalyzer::sendEditorState()
+{
+    // the plugin takes no notice until the refresh interval is measured
+    if (fReportedRefreshInterval <= 0)
+        return;
+
+    // the plugin takes a message which follows the previous in sequence,
+    // so the first is sent twice
+    if (!fEditorStateSent) {
+        fEditorSerial = std::random_device()();
+        fEditorStateSent = true;
+        sendEditorState();
+    }
+
+    char text[64];
+    std::snprintf(text, sizeof(text), "%d %g %u", (int)fReportedVisible, fReportedRefreshInterval, ++fEditorSerial);
+    setState("editor", text);
+    fEditorStateTime = std::chrono::steady_clock::now();
+}
+
 void UISpectralAnalyzer::updateSpectrum()
 {
+    TRACE_SCOPE("updateSpectrum");
+
+    // otherwise, the frames come as states
     PluginSpectralAnalyzer *plugin = getPluginInstance();
-    DISTRHO_SAFE_ASSERT_RETURN(plugin, );
+    if (!plugin || fSpectrumView->isFrozen())
+        return;
 
     std::unique_lock<SpinMutex> lock(plugin->fSendMutex);
-    fFrequencies = plugin->fSendFrequencies;
-    fMagnitudes = plugin->fSendMagnitudes;
+    if (plugin->fSendGeneration == fGeneration)
+        return;
+    fGeneration = plugin->fSendGeneration;
     fSize = plugin->fSendSize;
+    fNumCurves = plugin->fSendNumCurves;
+    fChannelMode = plugin->fSendChannelMode;
+    fFrequencies.assign(plugin->fSendFrequencies.begin(), plugin->fSendFrequencies.begin() + fSize * fNumCurves);
+    fMagnitudes.assign(plugin->fSendMagnitudes.begin(), plugin->fSendMagnitudes.begin() + fSize * fNumCurves);
     lock.unlock();
 
-    fSpectrumView->setData(fFrequencies.data(), fMagnitudes.data(), fSize, kNumChannels);
+    findPeaks();
+    displaySpectrum();
+}
+
+void UISpectralAnalyzer::receiveFrame()
+{
+    TRACE_SCOPE("receiveFrame");
+
+    if (fSpectrumView->isFrozen())
+        return;
+
+    const uint32_t numBins = fDecoder.getNumBins();
+    const uint32_t numCurves = fDecoder.getNumCurves();
+    const ChannelMode channelMode = fDecoder.getChannelMode();
+    fSize = numBins;
+    fNumCurves = numCurves;
+    fChannelMode = channelMode;
+
+    // all the curves are on the same bins
+    fFrequencies.resize(numCurves * numBins);
+    for (uint32_t c = 0; c < numCurves; ++c)
+        std::copy_n(fDecoder.getFrequencies(), numBins, &fFrequencies[c * numBins]);
+    fMagnitudes.assign(fDecoder.getMagnitudes(), fDecoder.getMagnitudes() + numCurves * numBins);
+
+    ++fGeneration;
+    findPeaks();
+    displaySpectrum();
+}
+
+void UISpectralAnalyzer::findPeaks()
+{
+    TRACE_SCOPE("findPeaks");
+
+    // on the magnitude curves, once per frame received, off the audio thread
+    const uint32_t numBins = fSize;
+    const uint32_t numCurves = fNumCurves;
+    fPeaks.resize(numCurves * (numBins / 2));
+    fPeakOffsets.resize(numCurves + 1);
+    uint32_t numPeaks = 0;
+    for (uint32_t c = 0; c < numCurves; ++c) {
+        fPeakOffsets[c] = numPeaks;
+        if (getCurveKind(fChannelMode, kNumChannels, c) == kCurveMagnitude)
+            numPeaks += findSpectralPeaks(&fFrequencies[c * numBins], &fMagnitudes[c * numBins], numBins, &fPeaks[numPeaks]);
+    }
+    fPeakOffsets[numCurves] = numPeaks;
+    fPeaks.resize(numPeaks);
+}
+
+void UISpectralAnalyzer::displaySpectrum()
+{
+    const uint32_t numCurves = fNumCurves;
+    if (numCurves != getNumCurves(fChannelMode, kNumChannels) || fPeakOffsets.size() != numCurves + 1)
+        return;
+
+    // the magnitudes of channels in the colors of their channel, the others
+    // in their own
+    SpectrumView::CurveStyle styles[kMaxCurves];
+    for (uint32_t c = 0; c < numCurves; ++c) {
+        SpectrumView::CurveStyle &style = styles[c];
+        style.kind = getCurveKind(fChannelMode, kNumChannels, c);
+        switch (style.kind) {
+        case kCurveMagnitude:
+            switch (getCurveSignal(fChannelMode, kNumChannels, c)) {
+            case kSignalChannel:
+                style.lineColor = Colors::spectrum_line_channel1 + c;
+                style.fillColor = Colors::spectrum_fill_channel1 + c;
+                break;
+            case kSignalMid:
+                style.lineColor = Colors::spectrum_line_mid;
+                style.fillColor = -1;
+                break;
+            case kSignalSide:
+                style.lineColor = Colors::spectrum_line_side;
+                style.fillColor = -1;
+                break;
+            }
+            break;
+        case kCurveCoherence:
+            style.lineColor = Colors::spectrum_line_coherence;
+            style.fillColor = -1;
+            break;
+        case kCurvePhase:
+            style.lineColor = Colors::spectrum_line_phase;
+            style.fillColor = -1;
+            break;
+        case kCurveGain:
+            style.lineColor = Colors::spectrum_line_transfer;
+            style.fillColor = -1;
+            break;
+        }
+    }
+    fSpectrumView->setCurveStyles(styles, numCurves);
+
+    const uint32_t bandsPerOctave = fSpectrumView->bandsPerOctave();
+    if (bandsPerOctave > 0) {
+        BandAggregator &bands = fBandAggregator;
+        if (!bands.isConfiguredFor(fFrequencies.data(), fSize, bandsPerOctave))
+            bands.configure(fFrequencies.data(), fSize, bandsPerOctave);
+        const uint32_t numBands = bands.getNumBands();
+        fBandFrequencies.resize(numBands * numCurves);
+        fBandMagnitudes.resize(numBands * numCurves);
+        for (uint32_t c = 0; c < numCurves; ++c) {
+            std::copy_n(bands.getBandFrequencies(), numBands, fBandFrequencies.data() + c * numBands);
+            const float *binValues = fMagnitudes.data() + c * fSize;
+            float *bandValues = fBandMagnitudes.data() + c * numBands;
+            if (styles[c].kind == kCurveMagnitude)
+                bands.process(binValues, bandValues);
+            else
+                bands.processLinear(binValues, bandValues);
+        }
+        fSpectrumView->setData(fBandFrequencies.data(), fBandMagnitudes.data(), numBands, numCurves);
+    }
+    else
+        fSpectrumView->setData(fFrequencies.data(), fMagnitudes.data(), fSize, numCurves);
+    fSpectrumView->setPeaks(fPeaks.data(), fPeakOffsets.data(), numCurves);
 
     if (fMode == kModeSelect)
         updateSelectModeDisplays();
@@ -791,7 +1145,17 @@ void UISpectralAnalyzer::updateSelectModeDisplays()
     fSelectLabelX->setText(toHzString(fSelectLastCursorFreq));
     fSelectLabelY->setText(toDbString(fSelectLastCursorMag));
 
+    // a row per magnitude curve on display, which the M/S mode has fewer
+    // of than the channels; the rows past them are left empty
+    const uint32_t numCurves = fSpectrumView->getNumCurvesOnDisplay();
     for (unsigned c = 0; c < kNumChannels; ++c) {
+        if (c >= numCurves || fSpectrumView->getCurveKindOnDisplay(c) != kCurveMagnitude) {
+            fSelectChannelY[c]->setText("");
+            fSelectNearPeakX[c]->setText("");
+            fSelectNearPeakY[c]->setText("");
+            continue;
+        }
+
         double mag = fSpectrumView->evalMagnitudeOnDisplay(c, fSelectLastCursorFreq);
         fSelectChannelY[c]->setText(toDbString(mag));
 
@@ -867,6 +1231,11 @@ void UISpectralAnalyzer::reloadThemeList()
 
 // -----------------------------------------------------------------------
 
+constexpr double UISpectralAnalyzer::kMinRefreshInterval;
+constexpr double UISpectralAnalyzer::kMaxRefreshInterval;
+
+// -----------------------------------------------------------------------
+
 UI *DISTRHO::createUI()
 {
     return new UISpectralAnalyzer();
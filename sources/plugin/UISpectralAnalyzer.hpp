@@ -27,11 +27,15 @@
 #pragma once
 #include "DistrhoUI.hpp"
 #include "PluginSpectralAnalyzer.hpp"
+#include "SpectrumTransport.h"
+#include "dsp/BandAggregator.h"
+#include "dsp/SpectralPeaks.h"
 #include "ui/components/MainToolBar.h"
 #include "SimpleIni.h"
 #include <string>
 #include <vector>
 #include <memory>
+#include <chrono>
 #include <sys/time.h> // timespec
 class SpectrumView;
 class FloatingWindow;
@@ -52,6 +56,7 @@ public:
 protected:
     void parameterChanged(uint32_t, float value) override;
     void programLoaded(uint32_t index) override;
+    void stateChanged(const char *key, const char *value) override;
     void sampleRateChanged(double newSampleRate) override;
 
     void uiIdle() override;
@@ -69,7 +74,14 @@ private:
 
     void setNewSelectionPositionByMouse(DGL::Point<int> pos);
 
+    void reportEditorVisible(bool visible);
+    void reportRefreshInterval(double interval);
+    void sendEditorState();
     void updateSpectrum();
+    void receiveFrame();
+    void findPeaks();
+    void displaySpectrum();
+    void updateRefreshInterval();
     void updateSelectModeDisplays();
 
     template <class W, class... A>
@@ -85,6 +97,7 @@ private:
 
 private:
     enum { kNumChannels = DISTRHO_PLUGIN_NUM_INPUTS };
+    enum { kMaxCurves = kNumChannels + 3 };
 
     SpectrumView *fSpectrumView = nullptr;
 
@@ -92,10 +105,15 @@ private:
 
     FloatingWindow *fSetupWindow = nullptr;
     SpinBoxChooser *fAlgorithmChooser = nullptr;
+    SpinBoxChooser *fChannelModeChooser = nullptr;
     SpinBoxChooser *fFftSizeChooser = nullptr;
     SpinBoxChooser *fStepSizeChooser = nullptr;
     Slider *fAttackTimeSlider = nullptr;
     Slider *fReleaseTimeSlider = nullptr;
+    SpinBoxChooser *fRendererChooser = nullptr;
+    SpinBoxChooser *fInterpolationChooser = nullptr;
+    SpinBoxChooser *fLoadMeterChooser = nullptr;
+    SpinBoxChooser *fDisplayChooser = nullptr;
 
     FloatingWindow *fScaleWindow = nullptr;
     SelectionRectangle *fSelectionRectangle = nullptr;
@@ -122,7 +140,34 @@ private:
 
     std::vector<float> fFrequencies;
     std::vector<float> fMagnitudes;
+    std::vector<SpectralPeak> fPeaks;
+    std::vector<uint32_t> fPeakOffsets;
     uint32_t fSize = 0;
+    uint32_t fNumCurves = 0;
+    ChannelMode fChannelMode = kChannelModeLeftRight;
+    uint32_t fGeneration = 0;
+
+    // fractional-octave display, computed from the bins of the analysis
+    BandAggregator fBandAggregator;
+    std::vector<float> fBandFrequencies;
+    std::vector<float> fBandMagnitudes;
+
+    // the period of idle calls, averaged, and the value last told to the DSP
+    static constexpr double kMinRefreshInterval = 1.0 / 240.0;
+    static constexpr double kMaxRefreshInterval = 0.25;
+    std::chrono::steady_clock::time_point fIdleTime;
+    double fRefreshInterval = 0;
+    double fReportedRefreshInterval = 0;
+
+    // without direct access to the plugin, the status of the editor is sent
+    // as a state, and the frames are received as one; the status is numbered
+    // and repeated, for the plugin to tell it from a restored value, and to
+    // know that the editor is still there
+    bool fReportedVisible = false;
+    uint32_t fEditorSerial = 0;
+    bool fEditorStateSent = false;
+    std::chrono::steady_clock::time_point fEditorStateTime;
+    SpectrumDecoder fDecoder { kNumChannels };
 
     enum {
         kModeNormal,
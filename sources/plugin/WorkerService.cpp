@@ -0,0 +1,123 @@
+#include "WorkerService.h"
+#include "util/trace_events.h"
+#include <algorithm>
+
+// few threads suffice, as the work is occasional, and the FFT plans are
+// created one at a time anyway
+static constexpr unsigned kMaxWorkers = 4;
+
+///
+std::shared_ptr<WorkerService> WorkerService::acquire()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<WorkerService> current;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<WorkerService> service = current.lock();
+    if (!service) {
+        service.reset(new WorkerService);
+        current = service;
+    }
+    return service;
+}
+
+WorkerService::WorkerService()
+{
+    const unsigned numThreads = std::max(1u, std::min(kMaxWorkers, std::thread::hardware_concurrency() / 2));
+    for (unsigned i = 0; i < numThreads; ++i)
+        fThreads.emplace_back([this]() { runWorker(); });
+}
+
+WorkerService::~WorkerService()
+{
+    fQuit.store(true);
+    for (size_t i = 0; i < fThreads.size(); ++i)
+        fSemaphore.post();
+    for (std::thread &thread : fThreads)
+        thread.join();
+}
+
+WorkerService::Task *WorkerService::addTask(std::function<void()> function)
+{
+    Task *task = new Task(std::move(function));
+    std::lock_guard<std::mutex> lock(fMutex);
+    fTasks.emplace_back(task);
+    return task;
+}
+
+void WorkerService::removeTask(Task *task)
+{
+    std::unique_lock<std::mutex> lock(fMutex);
+    fTaskFinished.wait(lock, [task]() { return !task->running; });
+
+    auto it = std::find_if(fTasks.begin(), fTasks.end(),
+        [task](const std::unique_ptr<Task> &t) { return t.get() == task; });
+    if (it != fTasks.end())
+        fTasks.erase(it);
+}
+
+void WorkerService::post(Task *task)
+{
+    // keeps its place in the queue if it's pending already
+    if (!task->pending.load(std::memory_order_acquire))
+        task->postOrder.store(fPostCounter.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    task->pending.store(true, std::memory_order_release);
+    fSemaphore.post();
+}
+
+void WorkerService::runWorker()
+{
+    TRACE_THREAD_NAME("worker");
+
+    for (;;) {
+        fSemaphore.wait();
+        if (fQuit.load())
+            break;
+
+        // runs everything pending, since the posts which came while a task
+        // was running were not picked up by the other workers
+        for (;;) {
+            Task *task;
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                task = pickTask();
+                if (!task)
+                    break;
+                task->running = true;
+                task->pending.store(false, std::memory_order_release);
+            }
+
+            task->function();
+
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                task->running = false;
+            }
+            fTaskFinished.notify_all();
+        }
+    }
+}
+
+WorkerService::Task *WorkerService::pickTask()
+{
+    // the tasks are few, tens at most, so a scan does as well as a heap,
+    // and the posts from the audio thread need not take the lock
+    Task *best = nullptr;
+    int bestPriority = 0;
+    uint64_t bestOrder = 0;
+
+    for (const std::unique_ptr<Task> &t : fTasks) {
+        Task *task = t.get();
+        if (task->running || !task->pending.load(std::memory_order_acquire))
+            continue;
+        const int priority = task->priority.load(std::memory_order_relaxed);
+        const uint64_t order = task->postOrder.load(std::memory_order_relaxed);
+        if (!best || priority > bestPriority || (priority == bestPriority && order < bestOrder)) {
+            best = task;
+            bestPriority = priority;
+            bestOrder = order;
+        }
+    }
+
+    return best;
+}
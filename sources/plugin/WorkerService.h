@@ -0,0 +1,67 @@
+#pragma once
+#include <RTSemaphore.h>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+///
+// Worker threads shared by all the plugin instances of the process, which run
+// their work off the audio thread: the reconfiguration of the analyzers, and
+// the creation of the FFT plans. It's started by its first user, and stopped
+// when the last one releases it.
+//
+// The users add tasks, and post them when there is work to do. A task runs on
+// one worker at a time; the posts which come while it waits or runs are
+// coalesced into one more run. The tasks of higher priority run first, and
+// those of equal priority in the order of their posts.
+class WorkerService {
+public:
+    enum Priority {
+        kPriorityNormal,
+        kPriorityHigh,
+    };
+
+    class Task {
+    public:
+        explicit Task(std::function<void()> function) : function(std::move(function)) {}
+
+        const std::function<void()> function;
+        std::atomic<bool> pending { false };
+        std::atomic<int> priority { kPriorityNormal };
+        std::atomic<uint64_t> postOrder { 0 };
+        bool running = false; // guarded by the service's mutex
+    };
+
+    static std::shared_ptr<WorkerService> acquire();
+    ~WorkerService();
+
+    // adds a task which calls `function` on a worker each time it's posted
+    Task *addTask(std::function<void()> function);
+    // removes a task, after waiting for it to finish if it runs
+    void removeTask(Task *task);
+
+    // realtime-safe
+    void post(Task *task);
+    static void setPriority(Task *task, Priority priority)
+        { task->priority.store(priority, std::memory_order_relaxed); }
+
+private:
+    WorkerService();
+    void runWorker();
+    Task *pickTask();
+
+private:
+    std::vector<std::thread> fThreads;
+    RTSemaphore fSemaphore;
+    std::atomic<bool> fQuit { false };
+    std::atomic<uint64_t> fPostCounter { 0 };
+
+    std::mutex fMutex;
+    std::condition_variable fTaskFinished;
+    std::vector<std::unique_ptr<Task>> fTasks;
+};
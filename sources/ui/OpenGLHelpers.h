@@ -0,0 +1,66 @@
+#pragma once
+#include "OpenGL.hpp"
+#include "Widget.hpp"
+#include "Window.hpp"
+#include <cmath>
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+///
+// Sets up the fixed-function pipeline for drawing in pixel coordinates of a
+// widget, origin at its top-left, and restores the previous state after. The
+// viewport and the scissor cover the widget, at its absolute position in the
+// window and at the scale factor of the window.
+// It must be used outside of a NanoVG frame, since NanoVG defers its drawing.
+class DirectGLScope {
+public:
+    explicit DirectGLScope(const Widget &widget)
+    {
+        glPushAttrib(GL_ENABLE_BIT|GL_COLOR_BUFFER_BIT|GL_CURRENT_BIT|GL_LINE_BIT|GL_TEXTURE_BIT|GL_VIEWPORT_BIT|GL_SCISSOR_BIT);
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+        // GL counts the rows from the bottom of the window
+        const Window &window = widget.getParentWindow();
+        const double scale = window.getScaling();
+        const double width = widget.getWidth();
+        const double height = widget.getHeight();
+        const GLint x = (GLint)std::lround(widget.getAbsoluteX() * scale);
+        const GLint y = (GLint)std::lround((window.getHeight() - widget.getAbsoluteY() - height) * scale);
+        const GLsizei w = (GLsizei)std::lround(width * scale);
+        const GLsizei h = (GLsizei)std::lround(height * scale);
+        glViewport(x, y, w, h);
+        glScissor(x, y, w, h);
+        glEnable(GL_SCISSOR_TEST);
+
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0.0, width, height, 0.0, -1.0, 1.0);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    ~DirectGLScope()
+    {
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+
+        glPopClientAttrib();
+        glPopAttrib();
+    }
+
+    DirectGLScope(const DirectGLScope &) = delete;
+    DirectGLScope &operator=(const DirectGLScope &) = delete;
+};
@@ -1,10 +1,15 @@
 #include "SpectrumView.h"
 #include "ui/FontEngine.h"
 #include "plugin/ColorPalette.h"
+#include "util/format_string.h"
+#include "util/trace_events.h"
+#include "ui/OpenGLHelpers.h"
+#include "dsp/AnalyzerDefs.h"
 #include "Color.hpp"
 #include "Window.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #if defined(_WIN32)
 #undef near
 #endif
@@ -20,6 +25,27 @@ static double ftom(double f)
     return 69.0 + 12.0 * std::log2(f * (1.0 / 440.0));
 }
 
+// adds the duration of its scope to a profile entry, if any
+class ProfileTimer {
+public:
+    explicit ProfileTimer(double *entry)
+        : fEntry(entry)
+    {
+        if (entry)
+            fStart = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileTimer()
+    {
+        if (fEntry)
+            *fEntry += std::chrono::duration<double>(std::chrono::steady_clock::now() - fStart).count();
+    }
+
+private:
+    double *fEntry;
+    std::chrono::steady_clock::time_point fStart;
+};
+
 ///
 SpectrumView::SpectrumView(Widget *parent, const ColorPalette &palette)
     : NanoWidget(parent),
@@ -27,29 +53,180 @@ SpectrumView::SpectrumView(Widget *parent, const ColorPalette &palette)
 {
 }
 
+SpectrumView::~SpectrumView()
+{
+    // the GL context need not be current here; the texture goes with it,
+    // which is destroyed with the window after the view
+}
+
 void SpectrumView::setData(const float *frequencies, const float *magnitudes, uint32_t size, uint32_t numChannels)
 {
     Memory &mem = fActiveMemory;
+    const uint32_t count = size * numChannels;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double interval = std::chrono::duration<double>(now - fFrameTime).count();
+    fFrameTime = now;
+
+    // on the same frequency grid, with the curves of the same kinds and the
+    // same bands, start moving from the current display towards the new
+    // frame, and let animate() do the repaints
+    const auto sameStyle = [](const CurveStyle &a, const CurveStyle &b) {
+        return a.kind == b.kind && a.lineColor == b.lineColor && a.fillColor == b.fillColor;
+    };
+    if (fInterpolation && !fFreeze && !fSpectrogram &&
+        mem.size == size && mem.numChannels == numChannels &&
+        mem.bandsPerOctave == fBandsPerOctave &&
+        mem.styles.size() == fCurveStyles.size() &&
+        std::equal(fCurveStyles.begin(), fCurveStyles.end(), mem.styles.begin(), sameStyle) &&
+        std::equal(frequencies, frequencies + count, mem.frequencies.begin()))
+    {
+        fFromMagnitudes = mem.magnitudes;
+        fToMagnitudes.assign(magnitudes, magnitudes + count);
+        fFrameInterval = std::max(kMinFrameInterval, std::min(kMaxFrameInterval, interval));
+        fAnimating = true;
+        // the memory takes the first step now, not at the next idle
+        animate();
+        return;
+    }
+
+    fAnimating = false;
     mem.frequencies.assign(frequencies, frequencies + size * numChannels);
     mem.magnitudes.assign(magnitudes, magnitudes + size * numChannels);
     mem.size = size;
     mem.numChannels = numChannels;
+    mem.styles = fCurveStyles;
+    mem.bandsPerOctave = fBandsPerOctave;
     mem.dirty = true;
-    repaint();
+    if (!fFreeze) {
+        if (fSpectrogram)
+            addSpectrogramLine();
+        repaint();
+    }
+}
+
+void SpectrumView::setPeaks(const SpectralPeak *peaks, const uint32_t *peakOffsets, uint32_t numChannels)
+{
+    Memory &mem = fActiveMemory;
+    mem.peakOffsets.assign(peakOffsets, peakOffsets + numChannels + 1);
+    mem.peaks.assign(peaks, peaks + peakOffsets[numChannels]);
+}
+
+void SpectrumView::setCurveStyles(const CurveStyle *styles, uint32_t numCurves)
+{
+    fCurveStyles.assign(styles, styles + numCurves);
+}
+
+SpectrumView::CurveStyle SpectrumView::getCurveStyle(uint32_t channel) const
+{
+    const Memory &mem = getDisplayMemory();
+    if (channel < mem.styles.size())
+        return mem.styles[channel];
+
+    CurveStyle style;
+    style.kind = kCurveMagnitude;
+    style.lineColor = Colors::spectrum_line_channel1 + channel;
+    style.fillColor = Colors::spectrum_fill_channel1 + channel;
+    return style;
 }
 
 void SpectrumView::toggleFreeze()
 {
     fFreezeMemory = fActiveMemory;
     fFreeze = !fFreeze;
+    repaint();
+}
+
+void SpectrumView::toggleSpectrogram()
+{
+    fSpectrogram = !fSpectrogram;
+
+    if (fSpectrogram && fSpectrogramPixels.empty()) {
+        const ColorRGBA8 back = fColorPalette[Colors::spectrum_background];
+        fSpectrogramPixels.assign(kSpectrogramWidth * kSpectrogramHistory, ColorRGBA8{back.r, back.g, back.b, 0xff});
+        fSpectrogramPendingLines = kSpectrogramHistory;
+    }
+
+    repaint();
+}
+
+void SpectrumView::setInterpolation(bool interpolation)
+{
+    if (fInterpolation == interpolation)
+        return;
+
+    fInterpolation = interpolation;
+    if (!interpolation && fAnimating) {
+        // jump to the end of the current animation
+        fFrameInterval = 0;
+        animate();
+    }
+}
+
+void SpectrumView::animate()
+{
+    if (!fAnimating)
+        return;
+
+    Memory &mem = fActiveMemory;
+    const uint32_t count = fToMagnitudes.size();
+    DISTRHO_SAFE_ASSERT_RETURN(mem.magnitudes.size() == count && fFromMagnitudes.size() == count, );
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - fFrameTime).count();
+
+    float mu = 1;
+    if (!fFreeze && elapsed < fFrameInterval)
+        mu = elapsed / fFrameInterval;
+    else
+        fAnimating = false;
+
+    const float *from = fFromMagnitudes.data();
+    const float *to = fToMagnitudes.data();
+    float *magnitudes = mem.magnitudes.data();
+    for (uint32_t i = 0; i < count; ++i)
+        magnitudes[i] = from[i] + mu * (to[i] - from[i]);
+    mem.dirty = true;
+
+    if (!fFreeze)
+        repaint();
+}
+
+void SpectrumView::setDspLoad(float load)
+{
+    // only repaint when the displayed value changes
+    if (std::lrint(load * 10) == std::lrint(fDspLoad * 10))
+        return;
+
+    fDspLoad = load;
+    if (fShowDspLoad)
+        repaint();
+}
+
+void SpectrumView::setDspPeakLoad(float load)
+{
+    if (std::lrint(load * 10) == std::lrint(fDspPeakLoad * 10))
+        return;
+
+    fDspPeakLoad = load;
+    if (fShowDspLoad)
+        repaint();
+}
+
+void SpectrumView::setShowDspLoad(bool show)
+{
+    if (fShowDspLoad == show)
+        return;
+
+    fShowDspLoad = show;
+    repaint();
 }
 
 double SpectrumView::evalMagnitudeOnDisplay(uint32_t channel, double frequency) const
 {
     const Memory &mem = getDisplayMemory();
     DISTRHO_SAFE_ASSERT_RETURN(channel < mem.numChannels, 0.0);
-    const Spline &spline = mem.getSpline(channel);
-    return spline.interpolate(frequency);
+    return mem.evaluate(channel, frequency);
 }
 
 SpectrumView::Peak SpectrumView::findNearbyPeakOnDisplay(uint32_t channel, double frequency)
@@ -64,71 +241,43 @@ SpectrumView::Peak SpectrumView::findNearbyPeakOnDisplay(uint32_t channel, doubl
 
     const Spline &spline = mem.getSpline(channel);
 
-    // fprintf(stderr, "----- New search (C=%u) -----\n", channel);
-
-    // fprintf(stderr, "Size: %u %d\n", size, spline.countElements());
-    // fprintf(stderr, "Real Middle: F=%f M=%f\n", frequency, spline.interpolate(frequency));
-
+    // the peak is the one reached by climbing the slope under the cursor
     int32_t mid = spline.findElement(frequency);
 
-    // fprintf(stderr, "Near Middle: I=%d F=%f M=%f\n", mid, spline.getX(mid), spline.getY(mid));
-
     int32_t direction = 0;
     if (mid - 1 < 0)
         direction = +1;
     else if ((uint32_t)(mid + 1) >= size)
         direction = -1;
     else
-        direction = (spline.interpolate(frequency) < spline.getY(mid + 1)) ? +1 : -1;
-
-    // fprintf(stderr, "Peak direction: %d\n", direction);
-
-    auto indexValid = [size](int32_t i) {
-        return i >= 0 && (uint32_t)i < size;
-    };
-
-    int32_t near = mid;
-    while (indexValid(near + direction) && spline.getY(near + direction) >= spline.getY(near)) {
-        near += direction;
-        // fprintf(stderr, "Peak advance to: %d F=%f M=%f\n", near, spline.getX(near), spline.getY(near));
-    }
+        direction = (mem.evaluate(channel, frequency) < spline.getY(mid + 1)) ? +1 : -1;
 
-    if (0) {
-        pk.frequency = spline.getX(near);
-        pk.magnitude = spline.getY(near);
-    }
-    else {
-        // narrow peak down by repeated spline evaluations
-        constexpr uint32_t numEvaluations = 8;
-
-        const int32_t left = std::max(0, near - 1);
-        const int32_t right = std::min((int32_t)size - 1, near + 1);
-        double f1 = 0.5 * (spline.getX(near) + spline.getX(left));
-        double f2 = 0.5 * (spline.getX(near) + spline.getX(right));
-
-        double f = 0.5 * (f1 + f2);
-        double m = spline.interpolate(f);
-        for (uint32_t i = 0; i < numEvaluations; ++i) {
-            double fc1 = 0.5 * (f + f1);
-            double mc1 = spline.interpolate(fc1);
-            if (mc1 > m) {
-                m = mc1;
-                f2 = f;
-            }
-            else {
-                double fc2 = 0.5 * (f + f2);
-                double mc2 = spline.interpolate(fc2);
-                m = mc2;
-                f1 = f;
-            }
-            f = 0.5 * (f1 + f2);
-        }
-        pk.frequency = f;
-        pk.magnitude = m;
-    }
-
-    // fprintf(stderr, "----- End search -----\n");
+    ///
+    pk.frequency = frequency;
+    pk.magnitude = mem.evaluate(channel, frequency);
+
+    if (mem.peakOffsets.size() != mem.numChannels + 1)
+        return pk;
+
+    const SpectralPeak *first = mem.peaks.data() + mem.peakOffsets[channel];
+    const SpectralPeak *last = mem.peaks.data() + mem.peakOffsets[channel + 1];
+    if (first == last)
+        return pk;
+
+    const SpectralPeak *next = std::upper_bound(
+        first, last, frequency,
+        [](double f, const SpectralPeak &p) -> bool { return f < p.frequency; });
+
+    const SpectralPeak *near;
+    if (next == first)
+        near = first;
+    else if (next == last)
+        near = last - 1;
+    else
+        near = (direction > 0) ? next : (next - 1);
 
+    pk.frequency = near->frequency;
+    pk.magnitude = near->magnitude;
     return pk;
 }
 
@@ -178,16 +327,95 @@ void SpectrumView::setReferenceLine(float key, float db)
     repaint();
 }
 
+const char *SpectrumView::getRendererName(int renderer)
+{
+    switch (renderer) {
+    case kRendererNanoVG: default:
+        return "NanoVG";
+    case kRendererOpenGL:
+        return "OpenGL";
+    }
+}
+
+void SpectrumView::setRenderer(int renderer)
+{
+    if (fRenderer == renderer)
+        return;
+
+    fRenderer = renderer;
+    repaint();
+}
+
 void SpectrumView::onNanoDisplay()
 {
+    TRACE_SCOPE("onNanoDisplay");
+
     save();
 
     ///
     const uint32_t width = getWidth();
     const uint32_t height = getHeight();
 
+    DisplayProfile *profile = fProfile;
+    if (profile)
+        ++profile->numFrames;
+
+    ///
+    if (fSpectrogram) {
+        // the texture is drawn outside of NanoVG, interrupt the frame after
+        // the background has been flushed, and resume it for the overlays
+        displayBack();
+        interruptFrame();
+        displaySpectrogramGL();
+        resumeFrame();
+        displayGrid(false);
+    }
+    else {
+        // the context is current while displaying, release the texture of
+        // the spectrogram once it's turned off
+        releaseSpectrogramTexture();
+        {
+            ProfileTimer timer(profile ? &profile->gridDrawing : nullptr);
+            displayBack();
+            displayGrid(true);
+        }
+        displayCurves();
+    }
+
+    ///
+    if (fHaveReferenceLine) {
+        const ColorPalette &cp = fColorPalette;
+        const double x = xOfKey(fKeyRef);
+        const double y = yOfDbMag(fdBref);
+
+        strokeWidth(1.0);
+        strokeColor(Colors::fromRGBA8(cp[Colors::spectrum_select_line]));
+
+        if (!fSpectrogram) {
+            beginPath();
+            moveTo(0.0, (int)y + 0.5);
+            lineTo(width, (int)y + 0.5);
+            stroke();
+        }
+
+        beginPath();
+        moveTo((int)x + 0.5, 0);
+        lineTo((int)x + 0.5, height);
+        stroke();
+    }
+
     ///
-    displayBack();
+    if (fShowDspLoad)
+        displayDspLoad();
+
+    ///
+    restore();
+}
+
+void SpectrumView::displayCurves()
+{
+    ///
+    const uint32_t width = getWidth();
 
     ///
     const Memory &mem = getDisplayMemory();
@@ -197,6 +425,15 @@ void SpectrumView::onNanoDisplay()
     if (size < 4) // need more elements for interpolation
         return;
 
+    DisplayProfile *profile = fProfile;
+
+    // splines of all channels are set up on first access
+    const uint32_t bandsPerOctave = mem.bandsPerOctave;
+    if (bandsPerOctave == 0) {
+        ProfileTimer timer(profile ? &profile->splineSetup : nullptr);
+        mem.getSpline(0);
+    }
+
     ///
     std::vector<PointF> points;
     points.reserve(width);
@@ -204,66 +441,295 @@ void SpectrumView::onNanoDisplay()
     ///
     const ColorPalette &cp = fColorPalette;
 
+    // the GL renderer draws outside of NanoVG, interrupt the frame after
+    // the background has been flushed, and resume it for the overlays
+    const bool directGL = fRenderer == kRendererOpenGL;
+    if (directGL) {
+        ProfileTimer timer(profile ? &profile->pathSubmission : nullptr);
+        interruptFrame();
+    }
+
     ///
     for (uint32_t channel = 0; channel < numChannels; ++channel) {
-        const Spline &spline = mem.getSpline(channel);
-
-        const ColorRGBA8 linecolor = cp[Colors::spectrum_line_channel1 + channel];
-        const ColorRGBA8 fillcolor = cp[Colors::spectrum_fill_channel1 + channel];
+        const CurveStyle style = getCurveStyle(channel);
+        const CurveKind kind = style.kind;
+        const ColorRGBA8 linecolor = cp[style.lineColor];
+        const ColorRGBA8 fillcolor = (style.fillColor != -1) ?
+            cp[style.fillColor] : ColorPalette::transparent();
 
         ///
-        points.clear();
-        for (uint32_t x = 0, step = 1; x <= width; x += step) {
-            const float f = frequencyOfX(x);
-            const float y = yOfDbMag(spline.interpolate(f));
-            points.emplace_back(x, y);
+        if (bandsPerOctave > 0) {
+            ProfileTimer timer(profile ? &profile->curveEvaluation : nullptr);
+            const float *frequencies = &mem.frequencies[channel * size];
+            const float *magnitudes = &mem.magnitudes[channel * size];
+            const double halfBand = std::exp2(0.5 / bandsPerOctave);
+            // a step per band, adjacent bands sharing their edges
+            points.clear();
+            for (uint32_t i = 0; i < size; ++i) {
+                const float y = yOfCurveValue(kind, magnitudes[i]);
+                points.emplace_back(xOfFrequency(frequencies[i] / halfBand), y);
+                points.emplace_back(xOfFrequency(frequencies[i] * halfBand), y);
+            }
         }
-
-        // plot line
-        if (linecolor.a > 0) {
-            beginPath();
-            moveTo(points[0].x, points[0].y);
-            for (uint32_t i = 1, n = points.size(); i < n; ++i)
-                lineTo(points[i].x, points[i].y);
-            strokeWidth(1.0);
-            strokeColor(Colors::fromRGBA8(linecolor));
-            stroke();
+        else {
+            const Spline &spline = mem.getSpline(channel);
+            ProfileTimer timer(profile ? &profile->curveEvaluation : nullptr);
+            points.clear();
+            for (uint32_t x = 0, step = 1; x <= width; x += step) {
+                const float f = frequencyOfX(x);
+                const float y = yOfCurveValue(kind, spline.interpolate(f));
+                points.emplace_back(x, y);
+            }
         }
 
-        // plot fill
-        if (fillcolor.a > 0) {
-            beginPath();
-            moveTo(points[0].x, points[0].y);
-            for (uint32_t i = 1, n = points.size(); i < n; ++i)
-                lineTo(points[i].x, points[i].y);
-            lineTo(points.back().x, height);
-            lineTo(points.front().x, height);
-            fillColor(Colors::fromRGBA8(fillcolor));
-            fill();
-        }
+        ProfileTimer timer(profile ? &profile->pathSubmission : nullptr);
+        if (directGL)
+            displayCurveGL(points, linecolor, fillcolor);
+        else
+            displayCurve(points, linecolor, fillcolor);
     }
 
-    ///
-    if (fHaveReferenceLine) {
-        const double x = xOfKey(fKeyRef);
-        const double y = yOfDbMag(fdBref);
+    if (directGL)
+        resumeFrame();
+}
 
-        strokeWidth(1.0);
-        strokeColor(Colors::fromRGBA8(cp[Colors::spectrum_select_line]));
+void SpectrumView::interruptFrame()
+{
+    restore();
+    endFrame();
+}
+
+void SpectrumView::resumeFrame()
+{
+    // as DPF begins the frame of a widget: over the window, at its scale
+    // factor, with the origin moved to the widget
+    const Window &window = getParentWindow();
+    beginFrame(window.getWidth(), window.getHeight(), window.getScaling());
+    translate(getAbsoluteX(), getAbsoluteY());
+    save();
+}
+
+void SpectrumView::displayCurve(const std::vector<PointF> &points, ColorRGBA8 linecolor, ColorRGBA8 fillcolor)
+{
+    const uint32_t height = getHeight();
 
+    // plot line
+    if (linecolor.a > 0) {
         beginPath();
-        moveTo(0.0, (int)y + 0.5);
-        lineTo(width, (int)y + 0.5);
+        moveTo(points[0].x, points[0].y);
+        for (uint32_t i = 1, n = points.size(); i < n; ++i)
+            lineTo(points[i].x, points[i].y);
+        strokeWidth(1.0);
+        strokeColor(Colors::fromRGBA8(linecolor));
         stroke();
+    }
 
+    // plot fill
+    if (fillcolor.a > 0) {
         beginPath();
-        moveTo((int)x + 0.5, 0);
-        lineTo((int)x + 0.5, height);
-        stroke();
+        moveTo(points[0].x, points[0].y);
+        for (uint32_t i = 1, n = points.size(); i < n; ++i)
+            lineTo(points[i].x, points[i].y);
+        lineTo(points.back().x, height);
+        lineTo(points.front().x, height);
+        fillColor(Colors::fromRGBA8(fillcolor));
+        fill();
+    }
+}
+
+void SpectrumView::displayCurveGL(const std::vector<PointF> &points, ColorRGBA8 linecolor, ColorRGBA8 fillcolor)
+{
+    const uint32_t height = getHeight();
+    const uint32_t count = points.size();
+
+    // pairs of vertices: the curve, and its projection on the bottom edge,
+    // forming a triangle strip for the fill; even vertices make the line
+    std::vector<float> &vertices = fVertices;
+    vertices.resize(4 * count);
+    for (uint32_t i = 0; i < count; ++i) {
+        vertices[4 * i] = points[i].x;
+        vertices[4 * i + 1] = points[i].y;
+        vertices[4 * i + 2] = points[i].x;
+        vertices[4 * i + 3] = height;
+    }
+
+    DirectGLScope scope(*this);
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    // plot fill
+    if (fillcolor.a > 0) {
+        glColor4ub(fillcolor.r, fillcolor.g, fillcolor.b, fillcolor.a);
+        glVertexPointer(2, GL_FLOAT, 2 * sizeof(float), vertices.data());
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 2 * count);
+    }
+
+    // plot line
+    if (linecolor.a > 0) {
+        glEnable(GL_LINE_SMOOTH);
+        glLineWidth(1.0);
+        glColor4ub(linecolor.r, linecolor.g, linecolor.b, linecolor.a);
+        glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), vertices.data());
+        glDrawArrays(GL_LINE_STRIP, 0, count);
+    }
+}
+
+void SpectrumView::displaySpectrogramGL()
+{
+    const uint32_t width = getWidth();
+    const uint32_t height = getHeight();
+    const uint32_t texWidth = kSpectrogramWidth;
+    const uint32_t texHeight = kSpectrogramHistory;
+
+    DISTRHO_SAFE_ASSERT_RETURN(fSpectrogramPixels.size() == texWidth * texHeight, );
+
+    DirectGLScope scope(*this);
+
+    ///
+    GLuint texture = fSpectrogramTexture;
+    if (!texture) {
+        glGenTextures(1, &texture);
+        fSpectrogramTexture = texture;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        fSpectrogramPendingLines = texHeight;
     }
+    else
+        glBindTexture(GL_TEXTURE_2D, texture);
 
     ///
-    restore();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    const uint32_t pending = fSpectrogramPendingLines;
+    if (pending >= texHeight) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, fSpectrogramPixels.data());
+    }
+    else if (pending > 0) {
+        // upload the lines received since last time, which may wrap around
+        const uint32_t last = fSpectrogramLine;
+        const uint32_t first = (last + texHeight + 1 - pending) % texHeight;
+        const uint32_t count1 = std::min(pending, texHeight - first);
+        const uint32_t count2 = pending - count1;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, texWidth, count1, GL_RGBA, GL_UNSIGNED_BYTE, &fSpectrogramPixels[first * texWidth]);
+        if (count2 > 0)
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texWidth, count2, GL_RGBA, GL_UNSIGNED_BYTE, &fSpectrogramPixels[0]);
+    }
+    fSpectrogramPendingLines = 0;
+
+    ///
+    glEnable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+    // the texture spans the default key range, map the current zoom into it
+    const double keySpan = kKeyMaxDefault - kKeyMinDefault;
+    const double s0 = (fKeyMin - kKeyMinDefault) / keySpan;
+    const double s1 = (fKeyMax - kKeyMinDefault) / keySpan;
+
+    // newest line at top, scroll down through the ring
+    const double t0 = double(fSpectrogramLine + 1) / texHeight;
+    const double t1 = t0 - 1.0;
+
+    glBegin(GL_QUADS);
+    glTexCoord2d(s0, t0);
+    glVertex2d(0.0, 0.0);
+    glTexCoord2d(s1, t0);
+    glVertex2d(width, 0.0);
+    glTexCoord2d(s1, t1);
+    glVertex2d(width, height);
+    glTexCoord2d(s0, t1);
+    glVertex2d(0.0, height);
+    glEnd();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SpectrumView::releaseSpectrogramTexture()
+{
+    GLuint texture = fSpectrogramTexture;
+    if (!texture)
+        return;
+
+    glDeleteTextures(1, &texture);
+    fSpectrogramTexture = 0;
+}
+
+void SpectrumView::addSpectrogramLine()
+{
+    const uint32_t texWidth = kSpectrogramWidth;
+    const uint32_t texHeight = kSpectrogramHistory;
+
+    if (fSpectrogramPixels.size() != texWidth * texHeight)
+        return;
+
+    const Memory &mem = fActiveMemory;
+    const uint32_t numChannels = mem.numChannels;
+
+    if (mem.size < 4) // need more elements for interpolation
+        return;
+
+    ///
+    const ColorPalette &cp = fColorPalette;
+    const ColorRGBA8 back = cp[Colors::spectrum_background];
+
+    const uint32_t line = (fSpectrogramLine + 1) % texHeight;
+    ColorRGBA8 *pixels = &fSpectrogramPixels[line * texWidth];
+
+    for (uint32_t x = 0; x < texWidth; ++x)
+        pixels[x] = ColorRGBA8{back.r, back.g, back.b, 0xff};
+
+    ///
+    const double dBmin = fdBmin;
+    const double dBrange = fdBmax - fdBmin;
+
+    for (uint32_t channel = 0; channel < numChannels; ++channel) {
+        // the other kinds of curves have no intensity
+        const CurveStyle style = getCurveStyle(channel);
+        if (style.kind != kCurveMagnitude)
+            continue;
+
+        const ColorRGBA8 color = cp[style.lineColor];
+
+        for (uint32_t x = 0; x < texWidth; ++x) {
+            const double key = kKeyMinDefault + (x + 0.5) * ((kKeyMaxDefault - kKeyMinDefault) / texWidth);
+            const double dB = mem.evaluate(channel, mtof(key));
+            const double intensity = std::max(0.0, std::min(1.0, (dB - dBmin) / dBrange));
+            if (intensity <= 0.0)
+                continue;
+
+            ColorRGBA8 &pixel = pixels[x];
+            pixel.r = std::min(0xff, int(pixel.r + intensity * color.r));
+            pixel.g = std::min(0xff, int(pixel.g + intensity * color.g));
+            pixel.b = std::min(0xff, int(pixel.b + intensity * color.b));
+        }
+    }
+
+    ///
+    fSpectrogramLine = line;
+    fSpectrogramPendingLines = std::min(fSpectrogramPendingLines + 1, texHeight);
+}
+
+void SpectrumView::displayDspLoad()
+{
+    const ColorPalette &cp = fColorPalette;
+    FontEngine fe(*this, cp);
+
+    Font font;
+    font.name = "regular";
+    font.size = 12;
+    font.colorRef = Colors::text_normal;
+
+    const std::string text = format_string("DSP %.1f%%, peak %.1f%%", fDspLoad, fDspPeakLoad);
+    const RectF box(getWidth() - 164, 4, 160, 20);
+
+    beginPath();
+    roundedRect(box.x, box.y, box.w, box.h, 4.0);
+    fillColor(Colors::fromRGBA8(cp[Colors::tool_bar_back]));
+    fill();
+
+    fe.drawInBox(text.c_str(), font, box, kAlignCenter|kAlignInside);
 }
 
 void SpectrumView::displayBack()
@@ -280,6 +746,16 @@ void SpectrumView::displayBack()
     rect(0.0, 0.0, width, height);
     fillColor(Colors::fromRGBA8(cp[Colors::spectrum_background]));
     fill();
+}
+
+void SpectrumView::displayGrid(bool withMagnitudes)
+{
+    const ColorPalette &cp = fColorPalette;
+    FontEngine fe(*this, cp);
+
+    ///
+    const uint32_t width = getWidth();
+    const uint32_t height = getHeight();
 
     ///
     Font font;
@@ -322,6 +798,9 @@ void SpectrumView::displayBack()
     }
 
     ///
+    if (!withMagnitudes)
+        return;
+
     const double dBmin = fdBmin;
     const double dBmax = fdBmax;
     constexpr double dBinterval = 12.0;
@@ -416,11 +895,28 @@ double SpectrumView::yOfDbMag(double m) const
     return (1 - rOfDbMag(m)) * getHeight();
 }
 
+double SpectrumView::yOfCurveValue(CurveKind kind, double v) const
+{
+    // the coherence spans the height from 0 to 1, the phase from -180 to 180,
+    // the gain by its own range
+    switch (kind) {
+    case kCurveMagnitude: default:
+        return yOfDbMag(v);
+    case kCurveGain:
+        return (0.5 - v * (0.5 / kGainRangeDB)) * getHeight();
+    case kCurveCoherence:
+        return (1.0 - v) * getHeight();
+    case kCurvePhase:
+        return (0.5 - v * (1.0 / 360.0)) * getHeight();
+    }
+}
+
 Spline &SpectrumView::Memory::getSpline(uint32_t channel) const
 {
     assert(channel < numChannels);
 
     if (dirty) {
+        TRACE_SCOPE("spline setup");
         lazySpline.resize(numChannels);
         for (uint32_t c = 0; c < numChannels; ++c)
             lazySpline[c].setup(&frequencies[c * size], &magnitudes[c * size], size);
@@ -430,7 +926,24 @@ Spline &SpectrumView::Memory::getSpline(uint32_t channel) const
     return lazySpline[channel];
 }
 
+double SpectrumView::Memory::evaluate(uint32_t channel, double frequency) const
+{
+    if (bandsPerOctave == 0)
+        return getSpline(channel).interpolate(frequency);
+
+    // the level of the band which contains the frequency, else the floor
+    const float *first = &frequencies[channel * size];
+    const float *last = first + size;
+    const double halfBand = std::exp2(0.5 / bandsPerOctave);
+    const float *band = std::upper_bound(first, last, (float)(frequency / halfBand));
+    if (band == last || frequency < *band / halfBand)
+        return kStftFloorMagnitudeInDB;
+    return magnitudes[channel * size + (band - first)];
+}
+
 constexpr float SpectrumView::kdBminDefault;
 constexpr float SpectrumView::kdBmaxDefault;
 constexpr float SpectrumView::kKeyMinDefault;
 constexpr float SpectrumView::kKeyMaxDefault;
+constexpr double SpectrumView::kMinFrameInterval;
+constexpr double SpectrumView::kMaxFrameInterval;
@@ -1,18 +1,48 @@
 #pragma once
 #include "NanoVG.hpp"
+#include "ui/Geometry.h"
+#include "ui/Color.h"
+#include "dsp/SpectralPeaks.h"
+#include "dsp/AnalyzerDefs.h"
 #include "spline/spline.h"
 #include <vector>
 #include <complex>
 #include <memory>
+#include <chrono>
 class ColorPalette;
 
 class SpectrumView : public NanoWidget {
 public:
     SpectrumView(Widget *parent, const ColorPalette &palette);
+    ~SpectrumView();
 
     void setData(const float *frequencies, const float *magnitudes, uint32_t size, uint32_t numChannels);
+    void setPeaks(const SpectralPeak *peaks, const uint32_t *peakOffsets, uint32_t numChannels);
+
+    // how to draw each curve of the data; the default for those without a
+    // style is a magnitude in the colors of its channel
+    struct CurveStyle {
+        CurveKind kind;
+        int lineColor;
+        int fillColor; // -1 for none
+    };
+    void setCurveStyles(const CurveStyle *styles, uint32_t numCurves);
     void toggleFreeze();
     bool isFrozen() const { return fFreeze; }
+    void toggleSpectrogram();
+    bool isSpectrogram() const { return fSpectrogram; }
+    void setInterpolation(bool interpolation);
+    bool interpolation() const { return fInterpolation; }
+    void animate();
+    void setDspLoad(float load);
+    void setDspPeakLoad(float load);
+    void setShowDspLoad(bool show);
+    bool showDspLoad() const { return fShowDspLoad; }
+    // when nonzero, the data are fractional-octave bands drawn as steps
+    void setBandsPerOctave(uint32_t bandsPerOctave) { fBandsPerOctave = bandsPerOctave; }
+    uint32_t bandsPerOctave() const { return fBandsPerOctave; }
+    uint32_t getNumCurvesOnDisplay() const { return getDisplayMemory().numChannels; }
+    CurveKind getCurveKindOnDisplay(uint32_t curve) const { return getCurveStyle(curve).kind; }
     double evalMagnitudeOnDisplay(uint32_t channel, double frequency) const;
     struct Peak { double frequency; double magnitude; };
     Peak findNearbyPeakOnDisplay(uint32_t channel, double frequency);
@@ -24,6 +54,27 @@ public:
     void clearReferenceLine();
     void setReferenceLine(float key, float db);
 
+    // accumulated times of the parts of the display in seconds, for profiling
+    struct DisplayProfile {
+        double splineSetup = 0;
+        double curveEvaluation = 0;
+        double gridDrawing = 0;
+        double pathSubmission = 0;
+        uint32_t numFrames = 0;
+    };
+
+    void setDisplayProfile(DisplayProfile *profile) { fProfile = profile; }
+
+    enum Renderer {
+        kRendererNanoVG,
+        kRendererOpenGL,
+        kNumRenderers,
+    };
+
+    static const char *getRendererName(int renderer);
+    int renderer() const { return fRenderer; }
+    void setRenderer(int renderer);
+
     void onNanoDisplay() override;
 
 public:
@@ -40,9 +91,21 @@ public:
     double dbMagOfR(double r) const;
     double rOfDbMag(double m) const;
     double yOfDbMag(double m) const;
+    double yOfCurveValue(CurveKind kind, double v) const;
 
 private:
     void displayBack();
+    void displayGrid(bool withMagnitudes);
+    void displayCurves();
+    void displayDspLoad();
+    void displaySpectrogramGL();
+    void releaseSpectrogramTexture();
+    void addSpectrogramLine();
+    CurveStyle getCurveStyle(uint32_t channel) const;
+    void displayCurve(const std::vector<PointF> &points, ColorRGBA8 linecolor, ColorRGBA8 fillcolor);
+    void displayCurveGL(const std::vector<PointF> &points, ColorRGBA8 linecolor, ColorRGBA8 fillcolor);
+    void interruptFrame();
+    void resumeFrame();
 
 private:
     struct Memory;
@@ -56,9 +119,14 @@ private:
         uint32_t numChannels;
         std::vector<float> frequencies;
         std::vector<float> magnitudes;
+        std::vector<SpectralPeak> peaks;
+        std::vector<uint32_t> peakOffsets;
+        std::vector<CurveStyle> styles;
+        uint32_t bandsPerOctave;
         mutable bool dirty;
         mutable std::vector<Spline> lazySpline;
         Spline &getSpline(uint32_t channel) const;
+        double evaluate(uint32_t channel, double frequency) const;
     };
 
     Memory fActiveMemory {};
@@ -73,6 +141,10 @@ private:
     static constexpr float kKeyMinDefault = 12.0;
     static constexpr float kKeyMaxDefault = 136.72627427729668f;
 
+    // the range of the transfer gains, around 0 dB in the middle, apart from
+    // the scale of the magnitudes which usually is all under 0 dB
+    static constexpr float kGainRangeDB = 60.0;
+
     // vertical scale (dB)
     float fdBmin = kdBminDefault;
     float fdBmax = kdBmaxDefault;
@@ -85,4 +157,43 @@ private:
     bool fHaveReferenceLine = false;
     float fKeyRef = 0;
     float fdBref = 0;
+
+    // curve rendering
+    int fRenderer = kRendererNanoVG;
+    std::vector<float> fVertices;
+
+    // profiling
+    DisplayProfile *fProfile = nullptr;
+
+    // styles of the curves of the next data
+    std::vector<CurveStyle> fCurveStyles;
+
+    // fractional-octave bands, 0 for the continuous spectrum
+    uint32_t fBandsPerOctave = 0;
+
+    // load meter, in percent
+    bool fShowDspLoad = false;
+    float fDspLoad = 0;
+    float fDspPeakLoad = 0;
+
+    // temporal interpolation: the displayed magnitudes move from where they
+    // were to the newest frame, over the time measured between two frames
+    static constexpr double kMinFrameInterval = 1.0 / 240.0;
+    static constexpr double kMaxFrameInterval = 0.25;
+    bool fInterpolation = true;
+    bool fAnimating = false;
+    std::vector<float> fFromMagnitudes;
+    std::vector<float> fToMagnitudes;
+    std::chrono::steady_clock::time_point fFrameTime;
+    double fFrameInterval = 0;
+
+    // spectrogram mode: a ring of lines on the default key scale, the newest
+    // at index fSpectrogramLine; only lines not yet in the texture get uploaded
+    static constexpr uint32_t kSpectrogramWidth = 1024;
+    static constexpr uint32_t kSpectrogramHistory = 512;
+    bool fSpectrogram = false;
+    std::vector<ColorRGBA8> fSpectrogramPixels;
+    uint32_t fSpectrogramLine = 0;
+    uint32_t fSpectrogramPendingLines = 0;
+    uint32_t fSpectrogramTexture = 0;
 };
@@ -0,0 +1,267 @@
+#include "realtime_checker.h"
+#if defined(RT_CHECKER)
+#include <atomic>
+#include <new>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+// the allocator of glibc, under its internal names
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+constexpr unsigned rt_checker_max_reports = 100;
+
+std::atomic<unsigned> rt_checker_count{0};
+
+// the depth of checked scopes on this thread; the TLS model is chosen so the
+// access never allocates, since it happens inside the allocator
+__attribute__((tls_model("initial-exec")))
+thread_local unsigned rt_checker_depth = 0;
+
+void rt_checker_write(const char *text, size_t length)
+{
+    while (length > 0) {
+        ssize_t count = write(STDERR_FILENO, text, length);
+        if (count <= 0)
+            return;
+        text += count;
+        length -= count;
+    }
+}
+
+void rt_checker_report(const char *function)
+{
+    // suspend the checks, since reporting allocates
+    const unsigned depth = rt_checker_depth;
+    rt_checker_depth = 0;
+
+    const unsigned count = rt_checker_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count <= rt_checker_max_reports) {
+        char text[256];
+        int length = snprintf(text, sizeof(text), "Realtime violation #%u: %s\n", count, function);
+        rt_checker_write(text, (size_t)length);
+
+        void *frames[64];
+        int numFrames = backtrace(frames, 64);
+        backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+
+        if (count == rt_checker_max_reports) {
+            length = snprintf(text, sizeof(text), "Further realtime violations are not reported\n");
+            rt_checker_write(text, (size_t)length);
+        }
+    }
+
+    if (getenv("SPECTACLE_RT_ABORT"))
+        abort();
+
+    rt_checker_depth = depth;
+}
+
+inline void rt_checker_check(const char *function)
+{
+    if (rt_checker_depth > 0)
+        rt_checker_report(function);
+}
+
+template <class F> F rt_checker_next(F &next, const char *name)
+{
+    if (!next)
+        next = reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+    return next;
+}
+
+void *rt_checker_new(size_t size, const char *function)
+{
+    rt_checker_check(function);
+
+    if (size == 0)
+        size = 1;
+
+    void *ptr;
+    while (!(ptr = __libc_malloc(size))) {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+    return ptr;
+}
+
+void rt_checker_delete(void *ptr, const char *function)
+{
+    if (ptr)
+        rt_checker_check(function);
+    __libc_free(ptr);
+}
+
+} // namespace
+
+void rt_checker_enter()
+{
+    ++rt_checker_depth;
+}
+
+void rt_checker_leave()
+{
+    --rt_checker_depth;
+}
+
+unsigned rt_checker_violations()
+{
+    return rt_checker_count.load(std::memory_order_relaxed);
+}
+
+///
+extern "C" {
+
+void *malloc(size_t size) noexcept
+{
+    rt_checker_check("malloc");
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    rt_checker_check("calloc");
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    rt_checker_check("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) noexcept
+{
+    if (ptr)
+        rt_checker_check("free");
+    __libc_free(ptr);
+}
+
+void *memalign(size_t alignment, size_t size) noexcept
+{
+    rt_checker_check("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    rt_checker_check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) noexcept
+{
+    rt_checker_check("posix_memalign");
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void *result = __libc_memalign(alignment, size);
+    if (!result)
+        return ENOMEM;
+    *ptr = result;
+    return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept
+{
+    static int (*next)(pthread_mutex_t *);
+    rt_checker_check("pthread_mutex_lock");
+    return rt_checker_next(next, "pthread_mutex_lock")(mutex);
+}
+
+int sem_wait(sem_t *sem)
+{
+    static int (*next)(sem_t *);
+    rt_checker_check("sem_wait");
+    return rt_checker_next(next, "sem_wait")(sem);
+}
+
+int sem_timedwait(sem_t *sem, const struct timespec *timeout)
+{
+    static int (*next)(sem_t *, const struct timespec *);
+    rt_checker_check("sem_timedwait");
+    return rt_checker_next(next, "sem_timedwait")(sem, timeout);
+}
+
+int nanosleep(const struct timespec *duration, struct timespec *remaining)
+{
+    static int (*next)(const struct timespec *, struct timespec *);
+    rt_checker_check("nanosleep");
+    return rt_checker_next(next, "nanosleep")(duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec *duration, struct timespec *remaining)
+{
+    static int (*next)(clockid_t, int, const struct timespec *, struct timespec *);
+    rt_checker_check("clock_nanosleep");
+    return rt_checker_next(next, "clock_nanosleep")(clock, flags, duration, remaining);
+}
+
+int usleep(useconds_t duration)
+{
+    static int (*next)(useconds_t);
+    rt_checker_check("usleep");
+    return rt_checker_next(next, "usleep")(duration);
+}
+
+} // extern "C"
+
+///
+void *operator new(size_t size)
+{
+    return rt_checker_new(size, "operator new");
+}
+
+void *operator new[](size_t size)
+{
+    return rt_checker_new(size, "operator new[]");
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try { return rt_checker_new(size, "operator new"); }
+    catch (...) { return nullptr; }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    try { return rt_checker_new(size, "operator new[]"); }
+    catch (...) { return nullptr; }
+}
+
+void operator delete(void *ptr) noexcept
+{
+    rt_checker_delete(ptr, "operator delete");
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    rt_checker_delete(ptr, "operator delete[]");
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    rt_checker_delete(ptr, "operator delete");
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    rt_checker_delete(ptr, "operator delete[]");
+}
+
+#endif
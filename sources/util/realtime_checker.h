@@ -0,0 +1,37 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Verification that the audio thread is realtime-safe, as a debugging aid.
+//
+// It is compiled in with RT_CHECKER. Inside a checked scope, any call to the
+// memory allocator or to a blocking function is a violation, which is printed
+// with its call stack on the standard error. If the variable SPECTACLE_RT_ABORT
+// is set, the first violation also aborts, to stop in the debugger.
+//
+// The hooks catch the calls made by the code of this module. Calls made inside
+// other libraries are caught only when the module is the main program.
+//------------------------------------------------------------------------------
+
+#if defined(RT_CHECKER)
+
+void rt_checker_enter();
+void rt_checker_leave();
+unsigned rt_checker_violations();
+
+class rt_checker_scope {
+public:
+    rt_checker_scope() { rt_checker_enter(); }
+    ~rt_checker_scope() { rt_checker_leave(); }
+    rt_checker_scope(const rt_checker_scope &) = delete;
+    rt_checker_scope &operator=(const rt_checker_scope &) = delete;
+};
+
+#define RT_CHECKER_SCOPE() rt_checker_scope rt_checker_scope_
+
+#else
+
+inline unsigned rt_checker_violations() { return 0; }
+
+#define RT_CHECKER_SCOPE() ((void)0)
+
+#endif
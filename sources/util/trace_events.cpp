@@ -0,0 +1,260 @@
+#include "trace_events.h"
+#if defined(ENABLE_TRACING)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t trace_max_threads = 16;
+constexpr uint32_t trace_max_events = 1u << 15;
+
+struct trace_event {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct trace_thread_buffer {
+    std::atomic<uint32_t> count{0};
+    std::atomic<const char *> name{nullptr};
+    trace_event events[trace_max_events];
+};
+
+struct trace_state {
+    std::unique_ptr<trace_thread_buffer[]> buffers{new trace_thread_buffer[trace_max_threads]};
+    std::atomic<uint32_t> num_threads{0};
+    std::string directory;
+    // tells apart the successive states, which may be at the same address
+    uint64_t generation = 0;
+};
+
+std::mutex trace_mutex;
+unsigned trace_users = 0;
+uint64_t trace_generations = 0;
+std::unique_ptr<trace_state> trace_owned;
+std::atomic<trace_state *> trace_current{nullptr};
+
+// the dump on request: the signal handler raises a flag, which a thread of
+// its own polls, as the handler can't save the file, nor can the audio thread
+int trace_signal = 0;
+struct sigaction trace_previous_action;
+std::atomic<bool> trace_dump_requested{false};
+std::thread trace_poll_thread;
+std::mutex trace_poll_mutex;
+std::condition_variable trace_poll_condition;
+bool trace_poll_quit = false;
+
+// the buffer of this thread, valid if it was claimed from the state of the
+// current generation
+thread_local trace_thread_buffer *trace_local_buffer = nullptr;
+thread_local uint64_t trace_local_generation = 0;
+
+trace_thread_buffer *trace_get_local_buffer(trace_state *state)
+{
+    if (trace_local_generation != state->generation) {
+        trace_local_generation = state->generation;
+        uint32_t index = state->num_threads.fetch_add(1, std::memory_order_relaxed);
+        trace_local_buffer = (index < trace_max_threads) ? &state->buffers[index] : nullptr;
+    }
+    return trace_local_buffer;
+}
+
+bool trace_dump_state(trace_state &state)
+{
+    const std::string path = state.directory + "/spectacle-" +
+        std::to_string(getpid()) + "-" + std::to_string(state.generation) + ".json";
+
+    FILE *stream = fopen(path.c_str(), "w");
+    if (!stream)
+        return false;
+
+    fprintf(stream, "{\"traceEvents\":[\n");
+
+    const uint32_t num_threads = std::min(trace_max_threads, state.num_threads.load(std::memory_order_relaxed));
+    bool first = true;
+    for (uint32_t tid = 0; tid < num_threads; ++tid) {
+        trace_thread_buffer &buffer = state.buffers[tid];
+        if (const char *name = buffer.name.load(std::memory_order_relaxed)) {
+            fprintf(stream, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", (int)getpid(), tid, name);
+            first = false;
+        }
+        const uint32_t count = buffer.count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; ++i) {
+            const trace_event &event = buffer.events[i];
+            fprintf(stream, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", event.name, (int)getpid(), tid,
+                    event.start * 1e-3, (event.end - event.start) * 1e-3);
+            first = false;
+        }
+    }
+
+    fprintf(stream, "\n]}\n");
+    return fclose(stream) == 0;
+}
+
+void trace_signal_handler(int)
+{
+    trace_dump_requested.store(true, std::memory_order_relaxed);
+}
+
+void trace_poll()
+{
+    std::unique_lock<std::mutex> lock(trace_poll_mutex);
+    while (!trace_poll_condition.wait_for(lock, std::chrono::milliseconds(100), []() { return trace_poll_quit; })) {
+        if (trace_dump_requested.exchange(false, std::memory_order_relaxed)) {
+            lock.unlock();
+            trace_dump();
+            lock.lock();
+        }
+    }
+}
+
+// a signal name without its prefix, such as USR1, or a number
+int trace_parse_signal(const char *text)
+{
+    if (!std::strcmp(text, "USR1"))
+        return SIGUSR1;
+    if (!std::strcmp(text, "USR2"))
+        return SIGUSR2;
+    if (!std::strcmp(text, "HUP"))
+        return SIGHUP;
+    return std::atoi(text);
+}
+
+void trace_start_signal()
+{
+    const char *text = getenv("SPECTACLE_TRACE_SIGNAL");
+    if (!text || !text[0])
+        return;
+
+    const int signal = trace_parse_signal(text);
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = &trace_signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (signal <= 0 || sigaction(signal, &action, &trace_previous_action) == -1) {
+        fprintf(stderr, "Cannot handle the signal %s to dump the trace\n", text);
+        return;
+    }
+
+    trace_signal = signal;
+    trace_poll_quit = false;
+    trace_poll_thread = std::thread(&trace_poll);
+}
+
+std::thread trace_stop_signal()
+{
+    if (trace_signal) {
+        sigaction(trace_signal, &trace_previous_action, nullptr);
+        trace_signal = 0;
+        std::lock_guard<std::mutex> lock(trace_poll_mutex);
+        trace_poll_quit = true;
+        trace_poll_condition.notify_one();
+    }
+    return std::move(trace_poll_thread);
+}
+
+} // namespace
+
+void trace_init()
+{
+    std::lock_guard<std::mutex> lock(trace_mutex);
+
+    if (trace_users++ > 0)
+        return;
+
+    const char *directory = getenv("SPECTACLE_TRACE");
+    if (!directory || !directory[0])
+        return;
+
+    trace_owned.reset(new trace_state);
+    trace_owned->directory.assign(directory);
+    trace_owned->generation = ++trace_generations;
+    trace_current.store(trace_owned.get(), std::memory_order_release);
+
+    trace_start_signal();
+}
+
+void trace_shutdown()
+{
+    std::thread poll_thread;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+
+        if (trace_users == 0 || --trace_users > 0)
+            return;
+
+        trace_current.store(nullptr, std::memory_order_release);
+        if (trace_owned) {
+            trace_dump_state(*trace_owned);
+            trace_owned.reset();
+        }
+
+        poll_thread = trace_stop_signal();
+    }
+
+    // outside of the lock, which a dump in progress takes
+    if (poll_thread.joinable())
+        poll_thread.join();
+}
+
+bool trace_dump()
+{
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    return trace_owned && trace_dump_state(*trace_owned);
+}
+
+bool trace_enabled()
+{
+    return trace_current.load(std::memory_order_relaxed) != nullptr;
+}
+
+uint64_t trace_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void trace_record(const char *name, uint64_t start, uint64_t end)
+{
+    trace_state *state = trace_current.load(std::memory_order_acquire);
+    if (!state)
+        return;
+
+    trace_thread_buffer *buffer = trace_get_local_buffer(state);
+    if (!buffer)
+        return;
+
+    // when full, the newer events are dropped
+    const uint32_t count = buffer->count.load(std::memory_order_relaxed);
+    if (count == trace_max_events)
+        return;
+
+    buffer->events[count] = trace_event{name, start, end};
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+void trace_thread_name(const char *name)
+{
+    trace_state *state = trace_current.load(std::memory_order_acquire);
+    if (!state)
+        return;
+
+    if (trace_thread_buffer *buffer = trace_get_local_buffer(state))
+        buffer->name.store(name, std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+// Recording of timed spans, which are saved in the Chrome trace format and can
+// be viewed in chrome://tracing or Perfetto.
+//
+// It is compiled in with ENABLE_TRACING, and it records only when the variable
+// SPECTACLE_TRACE names the directory where to save the traces. Each thread
+// writes to its own preallocated buffer, without locks; the trace is saved
+// when the last user calls trace_shutdown(), or at any time by trace_dump().
+//
+// If the variable SPECTACLE_TRACE_SIGNAL names a signal, USR1 for instance,
+// the trace is also saved whenever the process receives it; a thread polls
+// for the signal, so that the audio thread never writes the file.
+//------------------------------------------------------------------------------
+
+#if defined(ENABLE_TRACING)
+
+void trace_init();
+void trace_shutdown();
+bool trace_dump();
+
+bool trace_enabled();
+uint64_t trace_now();
+void trace_record(const char *name, uint64_t start, uint64_t end);
+void trace_thread_name(const char *name);
+
+class trace_scope {
+public:
+    explicit trace_scope(const char *name)
+        : name_(name), start_(trace_enabled() ? trace_now() : 0) {}
+    ~trace_scope()
+        { if (start_) trace_record(name_, start_, trace_now()); }
+    trace_scope(const trace_scope &) = delete;
+    trace_scope &operator=(const trace_scope &) = delete;
+private:
+    const char *name_;
+    uint64_t start_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// `name` must be a string literal, or have static storage
+#define TRACE_SCOPE(name) trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) trace_thread_name(name)
+
+#else
+
+inline void trace_init() {}
+inline void trace_shutdown() {}
+inline bool trace_dump() { return false; }
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif